@@ -6,6 +6,8 @@
 #define AUTOTIMER_AUTOTIMER_HH
 
 #include <algorithm>
+#include <cstdint>
+#include <cstdlib>
 #include <functional>
 #include <iomanip>
 #include <iostream>
@@ -18,9 +20,15 @@
 #include <vector>
 #include <tuple>
 
+#include "impl/allocations.hh"
 #include "impl/analytic.hh"
+#include "impl/baseline.hh"
+#include "impl/chrome_trace.hh"
+#include "impl/clocks.hh"
 #include "impl/export.hh"
 #include "impl/measurable.hh"
+#include "impl/optimizer.hh"
+#include "impl/result_store.hh"
 #include "impl/tasks.hh"
 #include "impl/time_record.hh"
 #include "impl/timer.hh"
@@ -28,22 +36,25 @@
 
 namespace AutoTimer
 {
-template < typename... Ts >
-class BasicBuilder
+template < typename Clock, typename... Ts >
+class ClockedBuilder
 {
 public:
-    explicit BasicBuilder( AutoTimer::Scaling::LabelledParameter< Ts >... params )
+    template < typename C, typename... Ps >
+    friend class ClockedBuilder;
+
+    explicit ClockedBuilder( AutoTimer::Scaling::LabelledParameter< Ts >... params )
         : scalingParameters( std::make_tuple( params... ) )
     {
     }
 
-    BasicBuilder& withLabel( const char* s )
+    ClockedBuilder& withLabel( const char* s )
     {
-        report.label = s;
+        results.label = s;
         return *this;
     }
 
-    BasicBuilder& withMultiplier( size_t n )
+    ClockedBuilder& withMultiplier( size_t n )
     {
         mult = n;
         for ( auto& m : ms )
@@ -54,7 +65,7 @@ public:
     }
 
     template < typename Function, typename = std::void_t< decltype( std::declval< Function >() ) > >
-    BasicBuilder& withInit( Function&& f )
+    ClockedBuilder& withInit( Function&& f )
     {
         init = std::forward< Function >( f );
         for ( auto& m : ms )
@@ -64,99 +75,601 @@ public:
         return *this;
     }
 
-    BasicBuilder& withOutputStream( std::ostream& output )
+    // run before every timed sample with the clock stopped, e.g. to restore the input of a
+    // mutating task
+    template < typename Function, typename = std::void_t< decltype( std::declval< Function >() ) > >
+    ClockedBuilder& withSetup( Function&& f )
+    {
+        TaskMultiDim< Ts... > t( std::forward< Function >( f ) );
+        setup = [ t ]( size_t, Ts... args ) { t( args... ); };
+        for ( auto& m : ms )
+        {
+            m.setup = setup;
+        }
+        return *this;
+    }
+
+    // like withSetup, but told how many invocations the next sample makes (see withBatch), so
+    // it can build one independent input per invocation
+    template < typename Function, typename = std::void_t< decltype( std::declval< Function >() ) > >
+    ClockedBuilder& withBatchSetup( Function&& f )
+    {
+        setup = std::forward< Function >( f );
+        for ( auto& m : ms )
+        {
+            m.setup = setup;
+        }
+        return *this;
+    }
+
+    template < typename Function, typename = std::void_t< decltype( std::declval< Function >() ) > >
+    ClockedBuilder& withTeardown( Function&& f )
+    {
+        teardown = std::forward< Function >( f );
+        for ( auto& m : ms )
+        {
+            m.teardown = teardown;
+        }
+        return *this;
+    }
+
+    // subtract the timing harness' own overhead (measured with an empty task) from every sample
+    ClockedBuilder& withOverheadSubtraction( bool enabled = true )
+    {
+        subtractOverhead = enabled;
+        for ( auto& m : ms )
+        {
+            m.withOverheadSubtraction( enabled );
+        }
+        return *this;
+    }
+
+    ClockedBuilder& withBatch( size_t k )
+    {
+        batch = k;
+        batchTarget.reset();
+        for ( auto& m : ms )
+        {
+            m.withBatch( k );
+        }
+        return *this;
+    }
+
+    ClockedBuilder& withAutoBatch( Duration target = std::chrono::microseconds( 10 ) )
+    {
+        batchTarget = target;
+        for ( auto& m : ms )
+        {
+            m.withAutoBatch( target );
+        }
+        return *this;
+    }
+
+    // report 95% confidence intervals of the mean and the median from this many bootstrap
+    // resamples; off by default since each resample redraws all the samples of a record and
+    // selects their median, so 1000 of them cost a thousand passes over every record
+    ClockedBuilder& withBootstrap( size_t resamples = 1000 )
+    {
+        bootstrapResamples = resamples;
+        for ( auto& m : ms )
+        {
+            m.withBootstrap( resamples );
+        }
+        return *this;
+    }
+
+    // sample every measure (and every scaling point) until the mean's 95% confidence interval
+    // is narrower than this fraction of the mean; the multiplier becomes the minimum run count
+    ClockedBuilder& withTargetPrecision( double relativeWidth )
+    {
+        targetPrecision = relativeWidth;
+        for ( auto& m : ms )
+        {
+            m.withTargetPrecision( relativeWidth );
+        }
+        return *this;
+    }
+
+    // the time each measure (and each scaling point) may spend on sampling
+    ClockedBuilder& withTimeBudget( Duration budget )
+    {
+        timeBudget = budget;
+        for ( auto& m : ms )
+        {
+            m.withTimeBudget( budget );
+        }
+        return *this;
+    }
+
+    ClockedBuilder& withWarmup( size_t n )
+    {
+        warmup = n;
+        warmupUntilStable = false;
+        for ( auto& m : ms )
+        {
+            m.withWarmup( n );
+        }
+        return *this;
+    }
+
+    ClockedBuilder& withWarmupUntilStable( size_t maxRuns = 1000 )
+    {
+        warmup = maxRuns;
+        warmupUntilStable = true;
+        for ( auto& m : ms )
+        {
+            m.withWarmupUntilStable( maxRuns );
+        }
+        return *this;
+    }
+
+    ClockedBuilder& withOutlierRejection( OutlierRejection rejection )
+    {
+        outlierRejection = rejection;
+        for ( auto& m : ms )
+        {
+            m.withOutlierRejection( rejection );
+        }
+        return *this;
+    }
+
+    // run every measure on n threads at once and report throughput and its efficiency against
+    // a single thread; with n = 0 the count comes from the scaling parameter labelled
+    // "threads", e.g. makeDiscrete( "threads", 1, 2, 4, 8, 16 ), and there must be one. The
+    // task must be thread-safe; not combinable with withParallelSweep(), withPerfCounters(),
+    // withAllocationTracking(), withTargetPrecision() or withTimeBudget()
+    ClockedBuilder& withThreads( size_t n = 0 )
+    {
+        threads = n;
+        for ( auto& m : ms )
+        {
+            configureThreads( m );
+        }
+        return *this;
+    }
+
+    // count cycles, instructions, branch/cache/TLB misses (or at least the software events
+    // where the kernel refuses the hardware ones) and report them per invocation
+    ClockedBuilder& withPerfCounters( bool enabled = true )
+    {
+        perfCounters = enabled;
+        for ( auto& m : ms )
+        {
+            m.withPerfCounters( enabled );
+        }
+        return *this;
+    }
+
+    // count heap allocations per invocation; define AUTOTIMER_TRACK_ALLOCATIONS before
+    // including autotimer in one translation unit to install the counting operator new/delete
+    ClockedBuilder& withAllocationTracking( bool enabled = true )
+    {
+        trackAllocations = enabled;
+        for ( auto& m : ms )
+        {
+            m.withAllocationTracking( enabled );
+        }
+        return *this;
+    }
+
+    // measure only some points of the scaling grid, e.g. Sampling::latinHypercube( 50 ), to
+    // explore a large parameter space with a bounded number of runs
+    ClockedBuilder& withSampling( const AutoTimer::Scaling::Sampling& s )
+    {
+        sampling = s;
+        return *this;
+    }
+
+    // sweep the scaling grid on worker threads pinned to distinct physical cores (all of them
+    // when workers is 0, optionally restricted to the given cpus); the task must be thread-safe.
+    // Not combinable with withThreads(): the contending threads would inherit the worker's
+    // single-core affinity and all share one core
+    ClockedBuilder& withParallelSweep( size_t workers = 0, std::vector< int > cpus = {} )
+    {
+        parallelSweep = true;
+        sweepWorkers = workers;
+        sweepCpus = std::move( cpus );
+        return *this;
+    }
+
+    ClockedBuilder& withTimeUnit( TimeUnitOptions opt )
+    {
+        timeUnitOption = opt;
+        return *this;
+    }
+
+    // render the report as text (default), or as a JSON or CSV document with one row per
+    // record keyed by the scaling parameters, for dashboards and regression trackers
+    ClockedBuilder& withOutputFormat( OutputFormat format )
+    {
+        outputFormat = format;
+        return *this;
+    }
+
+    // keep every measured sample in the records (and the JSON/CSV documents)
+    ClockedBuilder& withRawSamples( bool enabled = true )
+    {
+        keepSamples = enabled;
+        for ( auto& m : ms )
+        {
+            m.withRawSamples( enabled );
+        }
+        return *this;
+    }
+
+    // count every sample into a per-record HDR histogram with the given significant digits
+    // (1 to 5), which keeps the whole latency distribution at a fixed memory, for percentiles
+    // beyond the summary's and for merging records later
+    ClockedBuilder& withHistogram( int significantDigits = 2 )
+    {
+        histogramDigits = significantDigits;
+        for ( auto& m : ms )
+        {
+            m.withHistogram( significantDigits );
+        }
+        return *this;
+    }
+
+    // compare every record (keyed by report label, measure label and scaling coordinates) with
+    // the baseline file, reporting the points whose median changed by more than the relative
+    // tolerance, and failing on regressions unless told to warn; records missing from the file
+    // are added to it
+    ClockedBuilder& withBaseline( const std::string& path,
+                                  double tolerance = 0.1,
+                                  RegressionAction onRegression = RegressionAction::Fail )
+    {
+        baselinePath = path;
+        baselineTolerance = tolerance;
+        regressionAction = onRegression;
+        return *this;
+    }
+
+    // overwrite the baseline with this run instead of comparing (as does setting the
+    // AUTOTIMER_UPDATE_BASELINE environment variable)
+    ClockedBuilder& withBaselineUpdate( bool enabled = true )
+    {
+        updateBaseline = enabled;
+        return *this;
+    }
+
+    ClockedBuilder& withOutputStream( std::ostream& output )
     {
         os = &output;
         return *this;
     }
 
     template < typename... Ps >
-    BasicBuilder< Ps... > withScaling( AutoTimer::Scaling::LabelledParameter< Ps >... args )
+    ClockedBuilder< Clock, Ps... > withScaling(
+        AutoTimer::Scaling::LabelledParameter< Ps >... args )
+    {
+        ClockedBuilder< Clock, Ps... > builder( args... );
+        return builder;
+    }
+
+    // switch the clock used by the subsequent measures, e.g. withClock< TscClock >();
+    // the label, multiplier, init routine and output stream carry over
+    template < typename C >
+    ClockedBuilder< C, Ts... > withClock()
     {
-        BasicBuilder< Ps... > builder( args... );
+        auto builder = std::apply(
+            []( auto... params ) { return ClockedBuilder< C, Ts... >( params... ); },
+            scalingParameters );
+        builder.results.label = results.label;
+        builder.os = os;
+        builder.timeUnitOption = timeUnitOption;
+        builder.outputFormat = outputFormat;
+        builder.keepSamples = keepSamples;
+        builder.histogramDigits = histogramDigits;
+        builder.baselinePath = baselinePath;
+        builder.baselineTolerance = baselineTolerance;
+        builder.regressionAction = regressionAction;
+        builder.updateBaseline = updateBaseline;
+        builder.mult = mult;
+        builder.init = init;
+        builder.setup = setup;
+        builder.teardown = teardown;
+        builder.subtractOverhead = subtractOverhead;
+        builder.batch = batch;
+        builder.batchTarget = batchTarget;
+        builder.bootstrapResamples = bootstrapResamples;
+        builder.targetPrecision = targetPrecision;
+        builder.timeBudget = timeBudget;
+        builder.warmup = warmup;
+        builder.warmupUntilStable = warmupUntilStable;
+        builder.outlierRejection = outlierRejection;
+        builder.threads = threads;
+        builder.perfCounters = perfCounters;
+        builder.trackAllocations = trackAllocations;
+        builder.parallelSweep = parallelSweep;
+        builder.sampling = sampling;
+        builder.sweepWorkers = sweepWorkers;
+        builder.sweepCpus = sweepCpus;
+        fulfilled = true;
         return builder;
     }
 
-    BasicBuilder< Ts... >& measure( const TaskMultiDim< Ts... >& task )
+    // the task keeps its concrete type all the way into the timed loop
+    template < typename Function >
+    ClockedBuilder< Clock, Ts... >& measure( Function&& task )
     {
-        ms.emplace_back(
-            AutoTimer::Impl::Measurable< Ts... >( task ).withInit( init ).withMultiplier( mult ) );
+        ms.emplace_back( configured( AutoTimer::Impl::BasicMeasurable< Clock, Ts... >(
+            std::forward< Function >( task ) ) ) );
         return *this;
     }
 
-    BasicBuilder< Ts... >& measure( const char* label, const TaskMultiDim< Ts... >& task )
+    template < typename Function >
+    ClockedBuilder< Clock, Ts... >& measure( const char* label, Function&& task )
     {
-        ms.emplace_back( AutoTimer::Impl::Measurable< Ts... >( task )
-                             .withInit( init )
-                             .withMultiplier( mult )
+        ms.emplace_back( configured( AutoTimer::Impl::BasicMeasurable< Clock, Ts... >(
+                                         std::forward< Function >( task ) ) )
                              .withLabel( label ) );
         return *this;
     }
 
     void runMeasures()
     {
-        if constexpr ( sizeof...( Ts ) == 0 )
+        if ( parallelSweep && threads.has_value() )
         {
-            for ( const auto& m : ms )
-            {
-                auto summary = m.measure();
-                report.timeRecords.emplace_back( summary );
-            }
+            std::cerr << "withThreads can not be combined with withParallelSweep: the threads "
+                         "would share the core of their pinned sweep worker\n";
+            exit( 1 );
+        }
+        if ( threads.has_value()
+             && ( perfCounters || trackAllocations || targetPrecision || timeBudget ) )
+        {
+            std::cerr << "withThreads can not be combined with withPerfCounters, "
+                         "withAllocationTracking, withTargetPrecision or withTimeBudget: the "
+                         "threads take a fixed number of uncounted samples\n";
+            exit( 1 );
         }
-        else
+        if ( threads == size_t{ 0 } && !hasThreadsParameter() )
         {
-            for ( const auto& m : ms )
+            std::cerr << "withThreads() takes the thread count from the scaling parameter "
+                         "labelled \"threads\", but there is no such integral one\n";
+            exit( 1 );
+        }
+        for ( size_t i = 0; i < ms.size(); ++i )
+        {
+            auto record = static_cast< std::uint32_t >( i );
+            if constexpr ( sizeof...( Ts ) == 0 )
             {
-                auto r = AutoTimer::Scaling::scaleTu< Ts... >( m, scalingParameters );
-                report.timeRecords.template emplace_back( r );
+                results.append( record, {}, 0, ms[ i ].measureRecord() );
+            }
+            else
+            {
+                Scaling::scaleInto< Clock, Ts... >( results,
+                                                    record,
+                                                    ms[ i ],
+                                                    scalingParameters,
+                                                    sampling,
+                                                    parallelSweep,
+                                                    sweepWorkers,
+                                                    sweepCpus );
             }
         }
     }
 
-    void assertFaster()
+    // execute all the test subjects and ensure every subsequent one is faster than the first by
+    // at least the required speedup, at each scaling point; with enough runs (see
+    // Analytic::compareWithFirst()) the speedup must also be statistically significant
+    void assertFaster( double requiredSpeedup = 1.0 )
     {
         if ( !fulfilled )
         {
+            withRawSamples();
             runMeasures();
-            auto slowdown = Analytic::numSlowdown( report );
-            std::string indent{ "    " };
-            if ( slowdown == 0 )
-            {
-                report.formatted( std::cout, TimeUnitOptions::MicroSecond, indent )
-                    << indent << "assertFaster: passed\n";
-                fulfilled = true;
-            }
-            else
+            auto speedups = Analytic::compareWithFirst( results, requiredSpeedup );
+            auto passed = std::all_of(
+                speedups.cbegin(), speedups.cend(), []( const auto& s ) { return s.passed; } );
+            std::ostringstream details;
+            Analytic::renderSpeedups( details, "    ", speedups );
+            conclude( "assertFaster", passed, details.str() );
+        }
+    }
+
+    // execute all the test subjects and fit the time of every 1-D slice along the innermost
+    // scaling dimension against O(1), O(log n), O(n), O(n log n), O(n^2) and O(n^3); ensure
+    // none grows faster than the limit, e.g. to catch an accidental quadratic
+    void assertComplexity( Complexity limit )
+    {
+        static_assert( sizeof...( Ts ) > 0, "assertComplexity needs a scaling dimension" );
+        if ( !fulfilled )
+        {
+            runMeasures();
+            auto fits = Analytic::fitSlices( results );
+            auto passed = std::all_of( fits.cbegin(), fits.cend(), [ limit ]( const auto& f ) {
+                return Analytic::scalesNoWorseThan( f, limit );
+            } );
+            std::ostringstream details;
+            Analytic::renderFits( details, "    ", fits );
+            details << "    limit: " << Analytic::complexityName( limit ) << '\n';
+            conclude( "assertComplexity", passed, details.str() );
+        }
+    }
+
+    // execute all the test subjects with allocation tracking and ensure none of them allocates
+    // more than allowedPerOp times per invocation, e.g. to guard an allocation-free hot path
+    void assertNoMoreAllocations( double allowedPerOp = 0.0 )
+    {
+        if ( !fulfilled )
+        {
+            if ( !Allocations::installed() )
             {
-                report.formatted( std::cerr, TimeUnitOptions::MicroSecond, indent )
-                    << indent << "assertFaster: failed\n";
+                std::cerr << "assertNoMoreAllocations: allocation tracking is not installed, "
+                             "define AUTOTIMER_TRACK_ALLOCATIONS in one translation unit\n";
                 exit( 1 );
             }
+            withAllocationTracking();
+            runMeasures();
+            auto overAllocating = Analytic::numOverAllocating( results, allowedPerOp );
+            conclude( "assertNoMoreAllocations", overAllocating == 0 );
         }
     }
 
-    ~BasicBuilder()
+    ~ClockedBuilder()
     {
         if ( !fulfilled )
         {
             runMeasures();
-            report.formatted( os ? *os : std::cout, TimeUnitOptions::MicroSecond, "    " );
-            fulfilled = true;
+            conclude( nullptr, true );
         }
     };
 
 private:
-    std::vector< AutoTimer::Impl::Measurable< Ts... > > ms;
-    Report< Ts... > report{};
+    // write the report followed by the outcome of the assertion (if any) and of the baseline
+    // comparison, exiting when either failed; an assertion reports to stdout on success and to
+    // stderr otherwise, and documents (JSON, CSV) are kept valid by putting the verdicts on
+    // stderr
+    void conclude( const char* assertion, bool passed, const std::string& details = {} )
+    {
+        std::string indent{ "    " };
+        auto& out = assertion == nullptr ? ( os ? *os : std::cout )
+                    : passed             ? std::cout
+                                         : std::cerr;
+        results.write( out, outputFormat, timeUnitOption );
+        auto& notes = outputFormat == OutputFormat::Text ? out : std::cerr;
+        if ( assertion != nullptr && ( outputFormat == OutputFormat::Text || !passed ) )
+        {
+            notes << details << indent << assertion << ( passed ? ": passed\n" : ": failed\n" );
+        }
+        if ( !checkBaseline( notes, indent ) )
+        {
+            notes << indent << "baseline: failed\n";
+            passed = false;
+        }
+        if ( !passed )
+        {
+            exit( 1 );
+        }
+        fulfilled = true;
+    }
+
+    // false when a regression should fail the run
+    bool checkBaseline( std::ostream& notes, const std::string& indent ) const
+    {
+        if ( !baselinePath.has_value() )
+        {
+            return true;
+        }
+        auto current = Baseline::collect( results );
+        auto update = updateBaseline || std::getenv( "AUTOTIMER_UPDATE_BASELINE" ) != nullptr;
+        auto comparisons =
+            Baseline::compare( current, Baseline::load( baselinePath.value() ), baselineTolerance );
+        Baseline::Table additions{};
+        for ( const auto& c : comparisons )
+        {
+            if ( update || c.status == Baseline::Comparison::New )
+            {
+                additions[ c.key ] = c.current;
+            }
+        }
+        if ( !additions.empty() && !Baseline::save( baselinePath.value(), additions ) )
+        {
+            notes << indent << "baseline: can not write " << baselinePath.value() << '\n';
+        }
+        if ( update )
+        {
+            return true;
+        }
+        auto regressions = Baseline::renderComparisons( notes, indent, comparisons );
+        return regressions == 0 || regressionAction == RegressionAction::Warn;
+    }
+
+    AutoTimer::Impl::BasicMeasurable< Clock, Ts... > configured(
+        AutoTimer::Impl::BasicMeasurable< Clock, Ts... > m ) const
+    {
+        m.setup = setup;
+        m.teardown = teardown;
+        m.withInit( init ).withMultiplier( mult ).withOverheadSubtraction( subtractOverhead );
+        m.withBatch( batch ).withBootstrap( bootstrapResamples );
+        m.targetPrecision = targetPrecision;
+        m.timeBudget = timeBudget;
+        m.warmup = warmup;
+        m.warmupUntilStable = warmupUntilStable;
+        m.withOutlierRejection( outlierRejection );
+        if ( batchTarget.has_value() )
+        {
+            m.withAutoBatch( batchTarget.value() );
+        }
+        m.withPerfCounters( perfCounters ).withAllocationTracking( trackAllocations );
+        m.withRawSamples( keepSamples ).withHistogram( histogramDigits );
+        configureThreads( m );
+        return m;
+    }
+
+    // whether an integral scaling parameter is labelled "threads" (see withThreads())
+    [[nodiscard]] bool hasThreadsParameter() const
+    {
+        return std::apply(
+            []( const AutoTimer::Scaling::LabelledParameter< Ts >&... parameters ) {
+                return ( ( std::is_integral_v< Ts > && std::get< 0 >( parameters ) == "threads" )
+                         || ... );
+            },
+            scalingParameters );
+    }
+
+    void configureThreads( AutoTimer::Impl::BasicMeasurable< Clock, Ts... >& m ) const
+    {
+        if ( !threads.has_value() )
+        {
+            return;
+        }
+        m.withThreads( std::max< size_t >( threads.value(), 1 ) );
+        if ( threads.value() > 0 )
+        {
+            return;
+        }
+        size_t i{ 0 };
+        auto find = [ &m, &i ]( const auto& parameter ) {
+            if ( std::get< 0 >( parameter ) == "threads" && !m.threadsArgument.has_value() )
+            {
+                m.withThreadsFromArgument( i );
+            }
+            ++i;
+        };
+        std::apply( [ &find ]( const auto&... parameters ) { ( find( parameters ), ... ); },
+                    scalingParameters );
+    }
+
+    std::vector< AutoTimer::Impl::BasicMeasurable< Clock, Ts... > > ms;
+    ResultStore< Ts... > results{};
     TimeUnitOptions timeUnitOption{ TimeUnitOptions::MicroSecond };
+    OutputFormat outputFormat{ OutputFormat::Text };
     std::ostream* os{ nullptr };
     bool fulfilled{ false };
     size_t mult{ 1 };
+    bool subtractOverhead{ false };
+    size_t batch{ 1 };
+    std::optional< Duration > batchTarget{};
+    size_t bootstrapResamples{ 0 };
+    std::optional< double > targetPrecision{};
+    std::optional< Duration > timeBudget{};
+    size_t warmup{ 0 };
+    bool warmupUntilStable{ false };
+    OutlierRejection outlierRejection{ OutlierRejection::None };
+    std::optional< size_t > threads{};
+    bool perfCounters{ false };
+    bool trackAllocations{ false };
+    bool keepSamples{ false };
+    std::optional< int > histogramDigits{};
+    std::optional< std::string > baselinePath{};
+    double baselineTolerance{ 0.1 };
+    RegressionAction regressionAction{ RegressionAction::Fail };
+    bool updateBaseline{ false };
+    bool parallelSweep{ false };
+    size_t sweepWorkers{ 0 };
+    std::vector< int > sweepCpus{};
+    AutoTimer::Scaling::Sampling sampling{};
     std::optional< TaskMultiDim< Ts... > > init{};
+    std::optional< std::function< void( size_t, Ts... ) > > setup{};
+    std::optional< TaskMultiDim< Ts... > > teardown{};
 
     std::tuple< AutoTimer::Scaling::LabelledParameter< Ts >... > scalingParameters;
 };
 
+template < typename... Ts >
+using BasicBuilder = ClockedBuilder< DefaultClock, Ts... >;
+
 using Builder = BasicBuilder<>;
 
 };  // namespace AutoTimer
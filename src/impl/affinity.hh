@@ -0,0 +1,119 @@
+//
+// Created by weining on 18/10/26.
+//
+
+#ifndef AUTOTIMER_AFFINITY_HH
+#define AUTOTIMER_AFFINITY_HH
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#if defined( __linux__ )
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace AutoTimer::Affinity
+{
+// parses the kernel's cpu list format, e.g. "0-3,8,10-11"
+inline std::vector< int > parseCpuList( const std::string& s )
+{
+    std::vector< int > cpus;
+    std::stringstream ss( s );
+    std::string range;
+    while ( std::getline( ss, range, ',' ) )
+    {
+        if ( range.empty() )
+        {
+            continue;
+        }
+        auto dash = range.find( '-' );
+        auto lo = std::stoi( range.substr( 0, dash ) );
+        auto hi = dash == std::string::npos ? lo : std::stoi( range.substr( dash + 1 ) );
+        for ( auto cpu = lo; cpu <= hi; ++cpu )
+        {
+            cpus.push_back( cpu );
+        }
+    }
+    return cpus;
+}
+
+// the logical cpus sharing a physical core with the given one (itself included)
+inline std::vector< int > smtSiblings( int cpu )
+{
+    std::ifstream ifs( "/sys/devices/system/cpu/cpu" + std::to_string( cpu )
+                       + "/topology/thread_siblings_list" );
+    std::string line;
+    if ( ifs && std::getline( ifs, line ) )
+    {
+        return parseCpuList( line );
+    }
+    return { cpu };
+}
+
+// the cpus the calling thread may run on
+inline std::vector< int > allowedCpus()
+{
+    std::vector< int > cpus;
+#if defined( __linux__ )
+    cpu_set_t set;
+    CPU_ZERO( &set );
+    if ( sched_getaffinity( 0, sizeof( set ), &set ) == 0 )
+    {
+        for ( int cpu = 0; cpu < CPU_SETSIZE; ++cpu )
+        {
+            if ( CPU_ISSET( cpu, &set ) )
+            {
+                cpus.push_back( cpu );
+            }
+        }
+    }
+#endif
+    return cpus;
+}
+
+// one logical cpu per physical core, taken from the candidates (or all allowed cpus), so that no
+// two workers pinned to the result share a core through SMT
+inline std::vector< int > isolatedCores( const std::vector< int >& candidates = {} )
+{
+    auto allowed = allowedCpus();
+    std::vector< int > cores;
+    std::vector< int > taken;
+    for ( auto cpu : candidates.empty() ? allowed : candidates )
+    {
+        if ( std::find( allowed.cbegin(), allowed.cend(), cpu ) == allowed.cend() )
+        {
+            continue;
+        }
+        auto siblings = smtSiblings( cpu );
+        auto shared = std::any_of( siblings.cbegin(), siblings.cend(), [ &taken ]( int s ) {
+            return std::find( taken.cbegin(), taken.cend(), s ) != taken.cend();
+        } );
+        if ( shared )
+        {
+            continue;
+        }
+        cores.push_back( cpu );
+        taken.insert( taken.end(), siblings.cbegin(), siblings.cend() );
+    }
+    return cores;
+}
+
+inline bool pinCurrentThread( int cpu )
+{
+#if defined( __linux__ )
+    cpu_set_t set;
+    CPU_ZERO( &set );
+    CPU_SET( cpu, &set );
+    return pthread_setaffinity_np( pthread_self(), sizeof( set ), &set ) == 0;
+#else
+    return false;
+#endif
+}
+
+}  // namespace AutoTimer::Affinity
+
+#endif  // AUTOTIMER_AFFINITY_HH
@@ -0,0 +1,248 @@
+//
+// Created by weining on 18/10/26.
+//
+
+#ifndef AUTOTIMER_AGGREGATION_HH
+#define AUTOTIMER_AGGREGATION_HH
+
+#include "export.hh"
+#include "histogram.hh"
+#include "spans.hh"
+#include "time_record.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace AutoTimer::Aggregation
+{
+using namespace AutoTimer::TimeRecord;
+using Spans::LabelId;
+
+// the durations of one label: the histogram for the percentiles, the exact total for the mean
+struct LabelStats
+{
+    Hdr::Histogram histogram{};
+    Duration total{};
+
+    void merge( const LabelStats& other )
+    {
+        histogram.merge( other.histogram );
+        total += other.total;
+    }
+
+    [[nodiscard]] Summary summary( const std::string& label ) const
+    {
+        auto n = histogram.count();
+        return std::make_tuple( label,
+                                static_cast< size_t >( n ),
+                                n ? total / static_cast< long >( n ) : Duration{},
+                                histogram.min(),
+                                histogram.max() );
+    }
+};
+
+// the calling thread's statistics, indexed by label; the mutex is only contended while a
+// snapshot is being merged
+struct Shard
+{
+    std::mutex mu;
+    int significantDigits{ 2 };
+    std::vector< LabelStats > labels{};
+
+    void record( LabelId label, Duration d )
+    {
+        std::lock_guard< std::mutex > lock( mu );
+        if ( label >= labels.size() )
+        {
+            labels.resize( label + 1, LabelStats{ Hdr::Histogram( significantDigits ) } );
+        }
+        auto& stats = labels[ label ];
+        stats.histogram.record( d );
+        stats.total += d;
+    }
+};
+
+// a label's statistics merged over all threads
+struct Entry
+{
+    std::string label{};
+    LabelStats stats{};
+};
+
+// the registry of every thread's shard: recording touches the own shard only, reading merges
+// them all, either on demand (snapshot()) or periodically on a reporter thread
+class Registry
+{
+public:
+    static Registry& instance()
+    {
+        static Registry registry;
+        return registry;
+    }
+
+    Spans::LabelRegistry& labels()
+    {
+        return labelRegistry;
+    }
+
+    // the calling thread's shard, registered on first use
+    Shard& localShard()
+    {
+        thread_local std::shared_ptr< Shard > shard = registerThread();
+        return *shard;
+    }
+
+    LabelId localLabel( const char* s )
+    {
+        thread_local Spans::LabelCache cache;
+        return cache.lookup( s, labelRegistry );
+    }
+
+    // the precision of the histograms of threads registering afterwards
+    void withSignificantDigits( int digits )
+    {
+        std::lock_guard< std::mutex > lock( mu );
+        significantDigits = digits;
+    }
+
+    void withReportOnExit( std::ostream* output )
+    {
+        std::lock_guard< std::mutex > lock( mu );
+        reportStream = output;
+    }
+
+    // write a report every interval on a background thread, optionally starting every interval
+    // afresh; a null output stops the reports
+    void withPeriodicReport( std::ostream* output,
+                             std::chrono::milliseconds interval,
+                             bool resetEachInterval = false )
+    {
+        stopReporter();
+        if ( output == nullptr )
+        {
+            return;
+        }
+        std::lock_guard< std::mutex > lock( wakeMu );
+        stopping = false;
+        reporter = std::thread( [ this, output, interval, resetEachInterval ]() {
+            std::unique_lock< std::mutex > wakeLock( wakeMu );
+            while ( !wake.wait_for( wakeLock, interval, [ this ]() { return stopping; } ) )
+            {
+                wakeLock.unlock();
+                formatted( *output, TimeUnitOptions::MicroSecond, resetEachInterval );
+                wakeLock.lock();
+            }
+        } );
+    }
+
+    // every label's statistics merged over the threads, in the order the labels were first
+    // seen; with `reset` the shards start afresh
+    [[nodiscard]] std::vector< Entry > snapshot( bool reset = false )
+    {
+        std::vector< LabelStats > merged;
+        {
+            std::lock_guard< std::mutex > lock( mu );
+            for ( auto& shard : shards )
+            {
+                std::lock_guard< std::mutex > shardLock( shard->mu );
+                if ( shard->labels.size() > merged.size() )
+                {
+                    merged.resize( shard->labels.size(),
+                                   LabelStats{ Hdr::Histogram( shard->significantDigits ) } );
+                }
+                for ( size_t id = 0; id < shard->labels.size(); ++id )
+                {
+                    merged[ id ].merge( shard->labels[ id ] );
+                }
+                if ( reset )
+                {
+                    shard->labels.clear();
+                }
+            }
+        }
+        std::vector< Entry > entries;
+        for ( LabelId id = 0; id < merged.size(); ++id )
+        {
+            if ( !merged[ id ].histogram.empty() )
+            {
+                entries.push_back( { labelRegistry.name( id ), std::move( merged[ id ] ) } );
+            }
+        }
+        return entries;
+    }
+
+    // one line per label: the summary plus the percentiles from the merged histograms
+    std::ostream& formatted( std::ostream& os,
+                             AutoTimer::TimeUnitOptions opt,
+                             bool reset = false )
+    {
+        for ( const auto& entry : snapshot( reset ) )
+        {
+            const auto& h = entry.stats.histogram;
+            RecordMultiDim<> r{ entry.stats.summary( entry.label ) };
+            renderCastedSummary( os, 0, opt, r.castSummary( opt ) )
+                << " p50: " << castDuration( h.valueAtPercentile( 50 ), opt )
+                << ", p90: " << castDuration( h.valueAtPercentile( 90 ), opt )
+                << ", p99: " << castDuration( h.valueAtPercentile( 99 ), opt )
+                << ", p99.9: " << castDuration( h.valueAtPercentile( 99.9 ), opt ) << '\n';
+        }
+        return os;
+    }
+
+    ~Registry()
+    {
+        stopReporter();
+        if ( reportStream && !shards.empty() )
+        {
+            formatted( *reportStream, TimeUnitOptions::MicroSecond );
+        }
+    }
+
+private:
+    Registry() = default;
+
+    std::shared_ptr< Shard > registerThread()
+    {
+        auto shard = std::make_shared< Shard >();
+        std::lock_guard< std::mutex > lock( mu );
+        shard->significantDigits = significantDigits;
+        shards.push_back( shard );
+        return shard;
+    }
+
+    void stopReporter()
+    {
+        {
+            std::lock_guard< std::mutex > lock( wakeMu );
+            stopping = true;
+        }
+        wake.notify_all();
+        if ( reporter.joinable() )
+        {
+            reporter.join();
+        }
+    }
+
+    Spans::LabelRegistry labelRegistry;
+
+    std::mutex mu;
+    std::vector< std::shared_ptr< Shard > > shards;
+    int significantDigits{ 2 };
+    std::ostream* reportStream{ &std::cout };
+
+    std::mutex wakeMu;
+    std::condition_variable wake;
+    bool stopping{ false };
+    std::thread reporter;
+};
+
+}  // namespace AutoTimer::Aggregation
+
+#endif  // AUTOTIMER_AGGREGATION_HH
@@ -0,0 +1,231 @@
+//
+// Created by weining on 18/10/26.
+//
+
+#ifndef AUTOTIMER_ALLOCATIONS_HH
+#define AUTOTIMER_ALLOCATIONS_HH
+
+#include "time_record.hh"
+
+#include <cstddef>
+
+// Allocation tracking replaces the global operator new/delete, which a program may do only once:
+// define AUTOTIMER_TRACK_ALLOCATIONS before including autotimer in exactly one translation unit
+// (e.g. the one holding main()). Without it the measures report no allocation counts.
+
+namespace AutoTimer::Allocations
+{
+using TimeRecord::AllocationCounts;
+
+// counts of the calling thread; trivially initialized, so touching them never allocates
+struct ThreadCounts
+{
+    size_t allocations;
+    size_t frees;
+    size_t bytes;
+};
+
+inline ThreadCounts& threadCounts() noexcept
+{
+    thread_local ThreadCounts counts{};
+    return counts;
+}
+
+// whether the replacement operators are linked into the program
+inline bool& installed() noexcept
+{
+    static bool hooks{ false };
+    return hooks;
+}
+
+inline void recordAllocation( size_t bytes ) noexcept
+{
+    auto& counts = threadCounts();
+    ++counts.allocations;
+    counts.bytes += bytes;
+}
+
+inline void recordFree( void* p ) noexcept
+{
+    if ( p )
+    {
+        ++threadCounts().frees;
+    }
+}
+
+// accumulates what the calling thread allocates between start() and stop(), over any number of
+// such pairs
+class Counter
+{
+public:
+    void start() noexcept
+    {
+        begin = threadCounts();
+    }
+
+    void stop() noexcept
+    {
+        const auto& end = threadCounts();
+        total.allocations += end.allocations - begin.allocations;
+        total.frees += end.frees - begin.frees;
+        total.bytes += end.bytes - begin.bytes;
+    }
+
+    [[nodiscard]] AllocationCounts read( double invocations ) const
+    {
+        AllocationCounts c{};
+        c.tracked = installed();
+        if ( c.tracked && invocations > 0 )
+        {
+            c.allocations = static_cast< double >( total.allocations ) / invocations;
+            c.frees = static_cast< double >( total.frees ) / invocations;
+            c.bytes = static_cast< double >( total.bytes ) / invocations;
+        }
+        return c;
+    }
+
+private:
+    ThreadCounts begin{};
+    ThreadCounts total{};
+};
+
+}  // namespace AutoTimer::Allocations
+
+#if defined( AUTOTIMER_TRACK_ALLOCATIONS )
+
+#include <cstdlib>
+#include <new>
+
+namespace AutoTimer::Allocations
+{
+namespace
+{
+const bool hooksInstalled = ( installed() = true );
+
+void* allocate( size_t size, size_t alignment = 0 ) noexcept
+{
+    size = size ? size : 1;
+    void* p{ nullptr };
+    if ( alignment > alignof( std::max_align_t ) )
+    {
+        p = std::aligned_alloc( alignment, ( size + alignment - 1 ) / alignment * alignment );
+    }
+    else
+    {
+        p = std::malloc( size );
+    }
+    if ( p )
+    {
+        recordAllocation( size );
+    }
+    return p;
+}
+
+void* allocateOrThrow( size_t size, size_t alignment = 0 )
+{
+    while ( true )
+    {
+        if ( auto p = allocate( size, alignment ) )
+        {
+            return p;
+        }
+        auto handler = std::get_new_handler();
+        if ( !handler )
+        {
+            throw std::bad_alloc();
+        }
+        handler();
+    }
+}
+
+void release( void* p ) noexcept
+{
+    recordFree( p );
+    std::free( p );
+}
+}  // namespace
+}  // namespace AutoTimer::Allocations
+
+void* operator new( size_t size )
+{
+    return AutoTimer::Allocations::allocateOrThrow( size );
+}
+
+void* operator new[]( size_t size )
+{
+    return AutoTimer::Allocations::allocateOrThrow( size );
+}
+
+void* operator new( size_t size, const std::nothrow_t& ) noexcept
+{
+    return AutoTimer::Allocations::allocate( size );
+}
+
+void* operator new[]( size_t size, const std::nothrow_t& ) noexcept
+{
+    return AutoTimer::Allocations::allocate( size );
+}
+
+void* operator new( size_t size, std::align_val_t alignment )
+{
+    return AutoTimer::Allocations::allocateOrThrow( size, static_cast< size_t >( alignment ) );
+}
+
+void* operator new[]( size_t size, std::align_val_t alignment )
+{
+    return AutoTimer::Allocations::allocateOrThrow( size, static_cast< size_t >( alignment ) );
+}
+
+void operator delete( void* p ) noexcept
+{
+    AutoTimer::Allocations::release( p );
+}
+
+void operator delete[]( void* p ) noexcept
+{
+    AutoTimer::Allocations::release( p );
+}
+
+void operator delete( void* p, size_t ) noexcept
+{
+    AutoTimer::Allocations::release( p );
+}
+
+void operator delete[]( void* p, size_t ) noexcept
+{
+    AutoTimer::Allocations::release( p );
+}
+
+void operator delete( void* p, const std::nothrow_t& ) noexcept
+{
+    AutoTimer::Allocations::release( p );
+}
+
+void operator delete[]( void* p, const std::nothrow_t& ) noexcept
+{
+    AutoTimer::Allocations::release( p );
+}
+
+void operator delete( void* p, std::align_val_t ) noexcept
+{
+    AutoTimer::Allocations::release( p );
+}
+
+void operator delete[]( void* p, std::align_val_t ) noexcept
+{
+    AutoTimer::Allocations::release( p );
+}
+
+void operator delete( void* p, size_t, std::align_val_t ) noexcept
+{
+    AutoTimer::Allocations::release( p );
+}
+
+void operator delete[]( void* p, size_t, std::align_val_t ) noexcept
+{
+    AutoTimer::Allocations::release( p );
+}
+
+#endif  // AUTOTIMER_TRACK_ALLOCATIONS
+
+#endif  // AUTOTIMER_ALLOCATIONS_HH
@@ -6,11 +6,21 @@
 #define AUTOTIMER_ANALYTIC_HH
 
 #include "export.hh"
+#include "result_store.hh"
+#include "statistics.hh"
 #include "time_record.hh"
 
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
 namespace AutoTimer::Analytic
 {
-size_t numSlowdown( const AutoTimer::Report<>& report )
+inline size_t numSlowdown( const AutoTimer::Report<>& report )
 {
     auto& base = report.timeRecords[ 0 ];
     auto slowdown =
@@ -21,6 +31,313 @@ size_t numSlowdown( const AutoTimer::Report<>& report )
                        } );
     return slowdown;
 }
+
+// a candidate measured against the first measure of a report, at one scaling point
+struct Speedup
+{
+    std::string candidate{};
+    // label=value, ... of the scaling point, empty without scaling
+    std::string point{};
+    // the baseline's mean over the candidate's (see RecordMultiDim::speedUpFrom())
+    double ratio{};
+    // whether there were enough samples for the rank test, otherwise the verdict is the ratio's
+    bool tested{ false };
+    Stats::RankTest test{};
+    bool passed{ false };
+};
+
+// below this many samples on either side the rank test has too little power to be trusted
+constexpr size_t minSamplesForRankTest = 5;
+
+// compare every measure of the report with the first one at each scaling point: a candidate
+// passes when its samples, slowed down by the required speedup, are still smaller than the
+// baseline's at the given significance level (one-sided Mann-Whitney U test). The rank test
+// needs the raw samples (see withRawSamples()); without them the means decide
+template < typename... Ts >
+std::vector< Speedup > compareWithFirst( const AutoTimer::ResultStore< Ts... >& store,
+                                         double requiredSpeedup = 1.0,
+                                         double significance = 0.05 )
+{
+    std::vector< std::vector< size_t > > rows;
+    for ( size_t row = 0; row < store.size(); ++row )
+    {
+        rows.resize( std::max< size_t >( rows.size(), store.record[ row ] + 1 ) );
+        rows[ store.record[ row ] ].push_back( row );
+    }
+    auto toDoubles = []( Slice< Duration > ds, double factor ) {
+        std::vector< double > xs( ds.size() );
+        std::transform( ds.begin(), ds.end(), xs.begin(), [ factor ]( Duration d ) {
+            return static_cast< double >( d.count() ) * factor;
+        } );
+        return xs;
+    };
+    std::vector< Speedup > speedups;
+    for ( size_t i = 1; i < rows.size() && !rows[ 0 ].empty(); ++i )
+    {
+        for ( size_t k = 0; k < std::min( rows[ i ].size(), rows[ 0 ].size() ); ++k )
+        {
+            auto candidate = rows[ i ][ k ];
+            auto base = rows[ 0 ][ k ];
+            Speedup s{};
+            s.candidate = store.measureLabel( candidate ).empty()
+                              ? "measure " + std::to_string( i + 1 )
+                              : store.measureLabel( candidate );
+            for ( const auto& coordinate : store.coordinatesOf( candidate ) )
+            {
+                s.point += ( s.point.empty() ? "" : ", " ) + coordinate.label + '='
+                           + coordinate.value;
+            }
+            s.ratio = static_cast< double >( store.mean[ base ].count() )
+                      / static_cast< double >( store.mean[ candidate ].count() );
+            auto candidateSamples = store.samplesOf( candidate );
+            auto baseSamples = store.samplesOf( base );
+            s.tested = candidateSamples.size() >= minSamplesForRankTest
+                       && baseSamples.size() >= minSamplesForRankTest;
+            if ( s.tested )
+            {
+                s.test = Stats::mannWhitney( toDoubles( candidateSamples, requiredSpeedup ),
+                                             toDoubles( baseSamples, 1.0 ) );
+                s.passed = s.test.pValue < significance;
+            }
+            else
+            {
+                s.passed = s.ratio >= requiredSpeedup;
+            }
+            speedups.push_back( s );
+        }
+    }
+    return speedups;
+}
+
+template < typename... Ts >
+std::vector< Speedup > compareWithFirst( const AutoTimer::Report< Ts... >& report,
+                                         double requiredSpeedup = 1.0,
+                                         double significance = 0.05 )
+{
+    return compareWithFirst( report.results(), requiredSpeedup, significance );
+}
+
+inline std::ostream& renderSpeedups( std::ostream& os,
+                                     const std::string& indent,
+                                     const std::vector< Speedup >& speedups )
+{
+    auto precision = os.precision();
+    os << std::fixed;
+    for ( const auto& s : speedups )
+    {
+        os << indent << s.candidate;
+        if ( !s.point.empty() )
+        {
+            os << " (" << s.point << ')';
+        }
+        os << " speedup: " << std::setprecision( 4 ) << s.ratio << 'x';
+        if ( s.tested )
+        {
+            os << ", p: " << std::setprecision( 4 ) << s.test.pValue
+               << ", P(faster): " << std::setprecision( 2 ) << s.test.probabilitySmaller;
+        }
+        else
+        {
+            os << " (too few samples for a significance test)";
+        }
+        os << ( s.passed ? "\n" : ", failed\n" );
+    }
+    return os << std::defaultfloat << std::setprecision( static_cast< int >( precision ) );
+}
+
+inline const char* complexityName( Complexity c )
+{
+    static constexpr const char* names[]{
+        "O(1)", "O(log n)", "O(n)", "O(n log n)", "O(n^2)", "O(n^3)" };
+    return names[ static_cast< size_t >( c ) ];
+}
+
+inline double complexityOf( Complexity c, double n )
+{
+    auto logN = std::log2( std::max( n, 1.0 ) );
+    switch ( c )
+    {
+    case Complexity::O1:
+        return 1.0;
+    case Complexity::OLogN:
+        return logN;
+    case Complexity::ON:
+        return n;
+    case Complexity::ONLogN:
+        return n * logN;
+    case Complexity::ON2:
+        return n * n;
+    default:
+        return n * n * n;
+    }
+}
+
+struct Fit
+{
+    Complexity model{ Complexity::O1 };
+    // time (ns) = coefficient * model( n )
+    double coefficient{};
+    // the root mean square of the residuals relative to the times
+    double rms{};
+};
+
+// fits of time = c * g( n ) through the origin for every model g, the best (lowest RMS) first;
+// ties go to the slower growing model. The least squares minimise the residuals relative to the
+// times (weights 1 / t^2), so a noisy time at the largest size can not outweigh all the others;
+// a time of zero counts as one nanosecond
+inline std::vector< Fit > fitComplexity( const std::vector< double >& ns,
+                                         const std::vector< double >& times )
+{
+    std::vector< Fit > fits;
+    if ( ns.empty() || ns.size() != times.size() )
+    {
+        return fits;
+    }
+    for ( auto c = static_cast< int >( Complexity::O1 ); c <= static_cast< int >( Complexity::ON3 );
+          ++c )
+    {
+        Fit fit{ static_cast< Complexity >( c ) };
+        // with r = g / t, the relative residual is 1 - c * r
+        std::vector< double > rs( ns.size() );
+        double r1{ 0 }, r2{ 0 };
+        for ( size_t i = 0; i < ns.size(); ++i )
+        {
+            rs[ i ] = complexityOf( fit.model, ns[ i ] ) / ( times[ i ] > 0 ? times[ i ] : 1.0 );
+            r1 += rs[ i ];
+            r2 += rs[ i ] * rs[ i ];
+        }
+        fit.coefficient = r2 > 0 ? r1 / r2 : 0.0;
+        double sq{ 0 };
+        for ( auto r : rs )
+        {
+            auto residual = 1.0 - fit.coefficient * r;
+            sq += residual * residual;
+        }
+        fit.rms = std::sqrt( sq / static_cast< double >( ns.size() ) );
+        fits.push_back( fit );
+    }
+    std::stable_sort( fits.begin(), fits.end(), []( const Fit& a, const Fit& b ) {
+        return a.rms < b.rms;
+    } );
+    return fits;
+}
+
+// the fit of one 1-D slice of a record: the innermost scaling dimension, with the outer ones
+// fixed at `point`
+struct SliceFit
+{
+    std::string measure{};
+    std::string dimension{};
+    // label=value, ... of the outer dimensions, empty for a 1-D record
+    std::string point{};
+    size_t points{};
+    Fit best{};
+};
+
+// fewer distinct sizes than this can not tell the models apart
+constexpr size_t minPointsForFit = 3;
+
+// fit the median time (the mean of a record without a distribution) of every 1-D slice along
+// the innermost (arithmetic) scaling dimension; a slice is a run of rows of one record that
+// differ in the innermost coordinate only
+template < typename... Ts >
+std::vector< SliceFit > fitSlices( const AutoTimer::ResultStore< Ts... >& store )
+{
+    constexpr auto innermost = sizeof...( Ts ) - 1;
+    using T = std::tuple_element_t< innermost, std::tuple< Ts... > >;
+    static_assert( std::is_arithmetic_v< T >, "only numeric dimensions can be fitted" );
+    const auto& sizes = std::get< innermost >( store.coordinates );
+    std::vector< SliceFit > fits;
+    for ( size_t first = 0; first < store.size(); )
+    {
+        auto last = first + 1;
+        while ( last < store.size() && store.record[ last ] == store.record[ first ]
+                && store.divergence[ last ] == innermost )
+        {
+            ++last;
+        }
+        std::vector< double > ns, times;
+        for ( auto row = first; row < last; ++row )
+        {
+            ns.push_back( static_cast< double >( sizes[ row ] ) );
+            auto median = store.statistics[ row ].median;
+            times.push_back(
+                static_cast< double >( ( median.count() ? median : store.mean[ row ] ).count() ) );
+        }
+        SliceFit slice{};
+        slice.measure = store.measureLabel( first );
+        slice.dimension = store.dimensionLabel( innermost );
+        for ( const auto& coordinate : store.coordinatesOf( first, innermost ) )
+        {
+            slice.point +=
+                ( slice.point.empty() ? "" : ", " ) + coordinate.label + '=' + coordinate.value;
+        }
+        auto distinct = ns;
+        std::sort( distinct.begin(), distinct.end() );
+        slice.points = static_cast< size_t >(
+            std::unique( distinct.begin(), distinct.end() ) - distinct.begin() );
+        slice.best = fitComplexity( ns, times ).front();
+        fits.push_back( slice );
+        first = last;
+    }
+    return fits;
+}
+
+template < typename... Ts >
+std::vector< SliceFit > fitSlices( const AutoTimer::Report< Ts... >& report )
+{
+    return fitSlices( report.results() );
+}
+
+// whether the slice grows no faster than the given model; slices with too few sizes pass
+inline bool scalesNoWorseThan( const SliceFit& slice, Complexity limit )
+{
+    return slice.points < minPointsForFit || slice.best.model <= limit;
+}
+
+inline std::ostream& renderFits( std::ostream& os,
+                                 const std::string& indent,
+                                 const std::vector< SliceFit >& fits )
+{
+    auto precision = os.precision();
+    for ( const auto& f : fits )
+    {
+        os << indent << ( f.measure.empty() ? "measure" : f.measure );
+        if ( !f.point.empty() )
+        {
+            os << " (" << f.point << ')';
+        }
+        os << " over " << f.dimension << ": ";
+        if ( f.points < minPointsForFit )
+        {
+            os << "too few sizes to fit\n";
+            continue;
+        }
+        os << complexityName( f.best.model ) << ", coefficient: " << std::setprecision( 4 )
+           << f.best.coefficient << " nano, rms: " << std::fixed << std::setprecision( 1 )
+           << f.best.rms * 100 << "%\n"
+           << std::defaultfloat;
+    }
+    os << std::setprecision( static_cast< int >( precision ) );
+    return os;
+}
+
+// the records allocating more than the given number of times per invocation; records measured
+// without allocation tracking count as failing, as nothing can be said about them
+template < typename... Ts >
+size_t numOverAllocating( const AutoTimer::ResultStore< Ts... >& store, double allowedPerOp )
+{
+    return std::count_if( store.allocations.cbegin(),
+                          store.allocations.cend(),
+                          [ allowedPerOp ]( const AutoTimer::TimeRecord::AllocationCounts& a ) {
+                              return !a.tracked || a.allocations > allowedPerOp;
+                          } );
+}
+
+inline size_t numOverAllocating( const AutoTimer::Report<>& report, double allowedPerOp )
+{
+    return numOverAllocating( report.results(), allowedPerOp );
+}
 }  // namespace AutoTimer::Analytic
 
 #endif  // AUTOTIMER_ANALYTIC_HH
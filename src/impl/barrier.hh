@@ -0,0 +1,45 @@
+//
+// Created by weining on 18/10/26.
+//
+
+#ifndef AUTOTIMER_BARRIER_HH
+#define AUTOTIMER_BARRIER_HH
+
+#include <atomic>
+#include <cstddef>
+#include <thread>
+
+namespace AutoTimer::Impl
+{
+// a one-shot barrier releasing all participants at (nearly) the same instant: the waiters spin
+// instead of blocking so the release does not pay the scheduler's wakeup latency, and only start
+// yielding after a while in case there are more participants than cores
+class SpinBarrier
+{
+public:
+    explicit SpinBarrier( size_t participants ) : expected( participants )
+    {
+    }
+
+    void arriveAndWait()
+    {
+        arrived.fetch_add( 1, std::memory_order_acq_rel );
+        for ( size_t spins = 0; arrived.load( std::memory_order_acquire ) < expected; ++spins )
+        {
+            if ( spins >= spinLimit )
+            {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+private:
+    static constexpr size_t spinLimit = size_t{ 1 } << 14;
+
+    const size_t expected;
+    std::atomic< size_t > arrived{ 0 };
+};
+
+}  // namespace AutoTimer::Impl
+
+#endif  // AUTOTIMER_BARRIER_HH
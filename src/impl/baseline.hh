@@ -0,0 +1,210 @@
+//
+// Created by weining on 18/10/26.
+//
+
+#ifndef AUTOTIMER_BASELINE_HH
+#define AUTOTIMER_BASELINE_HH
+
+#include "export.hh"
+#include "result_store.hh"
+#include "time_record.hh"
+
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace AutoTimer::Baseline
+{
+using namespace AutoTimer::TimeRecord;
+
+// a baseline file is tab separated text with one line per record, so that it diffs well under
+// version control:
+//
+// report label, measure label, coordinates (label=value, ...), median (ns), mean (ns)
+//
+// records are keyed by the first three columns; a file may hold the baselines of many reports.
+// An unlabelled measure is named by its position ("measure 2"), and a point measured again
+// within a record (e.g. by a Constant parameter) is numbered from its second time on
+// ("n=5 #2"), so no two rows share a key
+struct Entry
+{
+    Duration median{};
+    Duration mean{};
+};
+
+using Table = std::map< std::string, Entry >;
+
+inline std::string sanitize( std::string s )
+{
+    for ( auto& c : s )
+    {
+        if ( c == '\t' || c == '\n' || c == '\r' )
+        {
+            c = ' ';
+        }
+    }
+    return s;
+}
+
+inline std::string key( const std::string& report,
+                        const std::string& measure,
+                        const Coordinates& coordinates )
+{
+    std::string point{};
+    for ( const auto& coordinate : coordinates )
+    {
+        point += ( point.empty() ? "" : ", " ) + coordinate.label + '=' + coordinate.value;
+    }
+    return sanitize( report ) + '\t' + sanitize( measure.empty() ? "measure" : measure ) + '\t'
+           + sanitize( point );
+}
+
+template < typename... Ts >
+Table collect( const ResultStore< Ts... >& store )
+{
+    Table table{};
+    std::map< std::string, size_t > occurrences{};
+    for ( size_t row = 0; row < store.size(); ++row )
+    {
+        const auto& label = store.measureLabel( row );
+        auto k = key( store.label,
+                      label.empty() ? "measure " + std::to_string( store.record[ row ] + 1 )
+                                    : label,
+                      store.coordinatesOf( row ) );
+        if ( auto n = ++occurrences[ k ]; n > 1 )
+        {
+            k += " #" + std::to_string( n );
+        }
+        table[ k ] = Entry{ store.statistics[ row ].median, store.mean[ row ] };
+    }
+    return table;
+}
+
+template < typename... Ts >
+Table collect( const Report< Ts... >& report )
+{
+    return collect( report.results() );
+}
+
+// an empty table when the file does not exist (yet); malformed lines are skipped
+inline Table load( const std::string& path )
+{
+    Table table{};
+    std::ifstream ifs( path );
+    std::string line;
+    while ( std::getline( ifs, line ) )
+    {
+        auto valueColumn = line.find( '\t', line.find( '\t', line.find( '\t' ) + 1 ) + 1 );
+        if ( line.empty() || line[ 0 ] == '#' || valueColumn == std::string::npos )
+        {
+            continue;
+        }
+        std::istringstream values( line.substr( valueColumn + 1 ) );
+        long median{}, mean{};
+        if ( values >> median >> mean )
+        {
+            table[ line.substr( 0, valueColumn ) ] = Entry{ Duration( median ), Duration( mean ) };
+        }
+    }
+    return table;
+}
+
+// merges the entries into the file, replacing those with the same key
+inline bool save( const std::string& path, const Table& entries )
+{
+    auto table = load( path );
+    for ( const auto& [ k, entry ] : entries )
+    {
+        table[ k ] = entry;
+    }
+    std::ofstream ofs( path, std::ios::trunc );
+    ofs << "# report\tmeasure\tcoordinates\tmedian_ns\tmean_ns\n";
+    for ( const auto& [ k, entry ] : table )
+    {
+        ofs << k << '\t' << entry.median.count() << '\t' << entry.mean.count() << '\n';
+    }
+    return static_cast< bool >( ofs );
+}
+
+struct Comparison
+{
+    enum Status
+    {
+        // not in the baseline
+        New,
+        Unchanged,
+        Improved,
+        Regressed,
+    };
+
+    std::string key{};
+    Status status{ New };
+    Entry baseline{};
+    Entry current{};
+
+    // current over baseline median, i.e. > 1 is slower
+    [[nodiscard]] double ratio() const
+    {
+        return baseline.median.count() > 0 ? static_cast< double >( current.median.count() )
+                                                 / static_cast< double >( baseline.median.count() )
+                                           : 1.0;
+    }
+};
+
+// compare the medians of every current entry with the baseline; a change within the relative
+// tolerance either way counts as unchanged
+inline std::vector< Comparison > compare( const Table& current,
+                                          const Table& baseline,
+                                          double tolerance )
+{
+    std::vector< Comparison > comparisons;
+    for ( const auto& [ k, entry ] : current )
+    {
+        Comparison c{ k, Comparison::New, {}, entry };
+        if ( auto found = baseline.find( k ); found != baseline.cend() )
+        {
+            c.baseline = found->second;
+            auto ratio = c.ratio();
+            c.status = ratio > 1 + tolerance   ? Comparison::Regressed
+                       : ratio < 1 - tolerance ? Comparison::Improved
+                                               : Comparison::Unchanged;
+        }
+        comparisons.push_back( c );
+    }
+    return comparisons;
+}
+
+// one line per regressed or improved grid point; returns the number of regressions
+inline size_t renderComparisons( std::ostream& os,
+                                 const std::string& indent,
+                                 const std::vector< Comparison >& comparisons )
+{
+    size_t regressions{ 0 };
+    for ( const auto& c : comparisons )
+    {
+        if ( c.status != Comparison::Regressed && c.status != Comparison::Improved )
+        {
+            continue;
+        }
+        regressions += c.status == Comparison::Regressed;
+        auto point = c.key.substr( c.key.find( '\t' ) + 1 );
+        for ( auto& ch : point )
+        {
+            ch = ch == '\t' ? ' ' : ch;
+        }
+        auto precision = os.precision();
+        os << indent << ( c.status == Comparison::Regressed ? "regressed: " : "improved: " )
+           << point << ' ' << std::fixed << std::setprecision( 2 ) << c.ratio()
+           << std::defaultfloat << std::setprecision( static_cast< int >( precision ) )
+           << "x (median " << c.current.median.count() << " vs " << c.baseline.median.count()
+           << " nano)\n";
+    }
+    return regressions;
+}
+
+}  // namespace AutoTimer::Baseline
+
+#endif  // AUTOTIMER_BASELINE_HH
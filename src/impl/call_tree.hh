@@ -0,0 +1,212 @@
+//
+// Created by weining on 18/10/26.
+//
+
+#ifndef AUTOTIMER_CALL_TREE_HH
+#define AUTOTIMER_CALL_TREE_HH
+
+#include "export.hh"
+#include "time_record.hh"
+
+#include <algorithm>
+#include <iterator>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace AutoTimer::Profile
+{
+using namespace AutoTimer::TimeRecord;
+
+// one node per distinct call path; inclusive time covers the children, self time does not
+struct CallNode
+{
+    std::string label{};
+    const char* key{ nullptr };
+    size_t count{};
+    Duration inclusive{};
+    Duration childTime{};
+    Duration min{};
+    Duration max{};
+    std::vector< std::unique_ptr< CallNode > > children{};
+
+    [[nodiscard]] Duration self() const
+    {
+        return inclusive - childTime;
+    }
+
+    // looks the child up by the address of its label first, confirmed by the content since a
+    // non-literal label may reuse an address
+    CallNode* child( const char* s )
+    {
+        for ( auto& c : children )
+        {
+            if ( c->key == s && c->label == s )
+            {
+                return c.get();
+            }
+        }
+        for ( auto& c : children )
+        {
+            if ( c->label == s )
+            {
+                c->key = s;
+                return c.get();
+            }
+        }
+        children.emplace_back( std::make_unique< CallNode >() );
+        children.back()->label = s;
+        children.back()->key = s;
+        return children.back().get();
+    }
+
+    void record( Duration d )
+    {
+        min = count ? std::min( min, d ) : d;
+        max = count ? std::max( max, d ) : d;
+        inclusive += d;
+        count += 1;
+    }
+
+    // fold another tree into this one, matching children by label
+    void merge( const CallNode& other )
+    {
+        if ( other.count )
+        {
+            min = count ? std::min( min, other.min ) : other.min;
+            max = count ? std::max( max, other.max ) : other.max;
+        }
+        count += other.count;
+        inclusive += other.inclusive;
+        childTime += other.childTime;
+        for ( const auto& c : other.children )
+        {
+            auto found = std::find_if( children.begin(),
+                                       children.end(),
+                                       [ &c ]( const auto& x ) { return x->label == c->label; } );
+            if ( found == children.end() )
+            {
+                children.emplace_back( std::make_unique< CallNode >() );
+                children.back()->label = c->label;
+                found = std::prev( children.end() );
+            }
+            ( *found )->merge( *c );
+        }
+    }
+};
+
+// the calling thread's tree and its stack of open scopes; the mutex is only contended while
+// a report is being merged
+struct ThreadTree
+{
+    std::mutex mu;
+    CallNode root{};
+    std::vector< CallNode* > stack{ &root };
+};
+
+class CallTreeRegistry
+{
+public:
+    static CallTreeRegistry& instance()
+    {
+        static CallTreeRegistry registry;
+        return registry;
+    }
+
+    ThreadTree& localTree()
+    {
+        thread_local std::shared_ptr< ThreadTree > tree = registerThread();
+        return *tree;
+    }
+
+    void withReportOnExit( std::ostream* output )
+    {
+        std::lock_guard< std::mutex > lock( mu );
+        reportStream = output;
+    }
+
+    // the union of every thread's tree; the root itself carries no timing
+    [[nodiscard]] CallNode merged()
+    {
+        CallNode root{};
+        std::lock_guard< std::mutex > lock( mu );
+        for ( auto& tree : trees )
+        {
+            std::lock_guard< std::mutex > treeLock( tree->mu );
+            root.merge( tree->root );
+        }
+        return root;
+    }
+
+    std::ostream& formatted( std::ostream& os, AutoTimer::TimeUnitOptions opt )
+    {
+        auto root = merged();
+        for ( const auto& c : sortedChildren( root ) )
+        {
+            renderNode( os, 0, opt, *c );
+        }
+        return os;
+    }
+
+    ~CallTreeRegistry()
+    {
+        if ( reportStream && !trees.empty() )
+        {
+            formatted( *reportStream, TimeUnitOptions::MicroSecond );
+        }
+    }
+
+private:
+    CallTreeRegistry() = default;
+
+    std::shared_ptr< ThreadTree > registerThread()
+    {
+        auto tree = std::make_shared< ThreadTree >();
+        std::lock_guard< std::mutex > lock( mu );
+        trees.push_back( tree );
+        return tree;
+    }
+
+    static std::vector< const CallNode* > sortedChildren( const CallNode& node )
+    {
+        std::vector< const CallNode* > xs;
+        for ( const auto& c : node.children )
+        {
+            xs.push_back( c.get() );
+        }
+        std::stable_sort( xs.begin(), xs.end(), []( const CallNode* a, const CallNode* b ) {
+            return a->inclusive > b->inclusive;
+        } );
+        return xs;
+    }
+
+    static void renderNode( std::ostream& os,
+                            size_t indent,
+                            AutoTimer::TimeUnitOptions opt,
+                            const CallNode& node )
+    {
+        auto avg = node.count ? node.inclusive / static_cast< long >( node.count ) : Duration{};
+        renderCastedSummary(
+            os,
+            indent,
+            opt,
+            RecordMultiDim<>( std::make_tuple( node.label, node.count, avg, node.min, node.max ) )
+                .castSummary( opt ) );
+        os << " inclusive: " << castDuration( node.inclusive, opt )
+           << ", self: " << castDuration( node.self(), opt ) << '\n';
+        for ( const auto& c : sortedChildren( node ) )
+        {
+            renderNode( os, indent + 4, opt, *c );
+        }
+    }
+
+    std::mutex mu;
+    std::vector< std::shared_ptr< ThreadTree > > trees;
+    std::ostream* reportStream{ &std::cout };
+};
+
+}  // namespace AutoTimer::Profile
+
+#endif  // AUTOTIMER_CALL_TREE_HH
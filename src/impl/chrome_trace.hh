@@ -0,0 +1,176 @@
+//
+// Created by weining on 18/10/26.
+//
+
+#ifndef AUTOTIMER_CHROME_TRACE_HH
+#define AUTOTIMER_CHROME_TRACE_HH
+
+#include "export.hh"
+#include "spans.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace AutoTimer::Spans
+{
+// writes every span as a complete ("X") event of the Chrome Trace Event format, which
+// chrome://tracing and ui.perfetto.dev both open; nested spans show as nested slices since they
+// share the thread and lie within each other. The events are formatted into a buffer on the
+// drainer thread and written out in chunks of bufferSize, so the timed threads never wait on
+// the file
+class ChromeTraceSink : public SpanSink
+{
+public:
+    ChromeTraceSink( std::ostream& os_,
+                     const LabelRegistry& labels_,
+                     std::size_t bufferSize_ = 1 << 16 )
+        : os{ &os_ }, labels{ labels_ }, bufferSize{ bufferSize_ }
+    {
+        buffer.reserve( bufferSize + 256 );
+        buffer += "{\"traceEvents\": [";
+    }
+
+    explicit ChromeTraceSink( const std::string& path,
+                              const LabelRegistry& labels_ = SpanCollector::instance().labels(),
+                              std::size_t bufferSize_ = 1 << 16 )
+        : ChromeTraceSink( file, labels_, bufferSize_ )
+    {
+        file.open( path );
+        if ( !file )
+        {
+            std::cerr << "can not write the trace to " << path << std::endl;
+            exit( 1 );
+        }
+    }
+
+    void consume( const SpanRecord& span ) override
+    {
+        std::lock_guard< std::mutex > lock( mu );
+        if ( closed )
+        {
+            return;
+        }
+        if ( span.thread >= threadsSeen.size() )
+        {
+            threadsSeen.resize( span.thread + 1, false );
+        }
+        if ( !threadsSeen[ span.thread ] )
+        {
+            threadsSeen[ span.thread ] = true;
+            separate() += "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": ";
+            buffer += std::to_string( span.thread );
+            buffer += ", \"args\": {\"name\": \"thread ";
+            buffer += std::to_string( span.thread );
+            buffer += "\"}}";
+        }
+        separate() += "{\"name\": ";
+        buffer += escapedName( span.label );
+        buffer += ", \"ph\": \"X\", \"pid\": 1, \"tid\": ";
+        buffer += std::to_string( span.thread );
+        appendMicroseconds( buffer += ", \"ts\": ", span.begin );
+        appendMicroseconds( buffer += ", \"dur\": ", span.end - span.begin );
+        buffer += '}';
+        if ( buffer.size() >= bufferSize )
+        {
+            writeBuffer();
+        }
+    }
+
+    // completes the JSON document and writes what is left; spans consumed afterwards are
+    // ignored. Flush the collector first to include the spans still in the rings
+    void close()
+    {
+        std::lock_guard< std::mutex > lock( mu );
+        if ( closed )
+        {
+            return;
+        }
+        closed = true;
+        buffer += "\n]}\n";
+        writeBuffer();
+        os->flush();
+    }
+
+    ~ChromeTraceSink() override
+    {
+        close();
+    }
+
+private:
+    std::string& separate()
+    {
+        buffer += numEvents++ ? ",\n" : "\n";
+        return buffer;
+    }
+
+    const std::string& escapedName( LabelId id )
+    {
+        if ( id >= names.size() )
+        {
+            names.resize( id + 1 );
+        }
+        if ( names[ id ].empty() )
+        {
+            std::ostringstream oss;
+            writeJsonString( oss, labels.name( id ) );
+            names[ id ] = oss.str();
+        }
+        return names[ id ];
+    }
+
+    // the format counts in microseconds; print the nanoseconds as a fixed-point fraction
+    // rather than through a double, which would round away the nanoseconds of an epoch time
+    static void appendMicroseconds( std::string& s, std::int64_t ns )
+    {
+        if ( ns < 0 )
+        {
+            s += '-';
+            ns = -ns;
+        }
+        s += std::to_string( ns / 1000 );
+        auto fraction = std::to_string( ns % 1000 );
+        s += '.';
+        s.append( 3 - fraction.size(), '0' );
+        s += fraction;
+    }
+
+    void writeBuffer()
+    {
+        os->write( buffer.data(), static_cast< std::streamsize >( buffer.size() ) );
+        buffer.clear();
+    }
+
+    std::ofstream file;
+    std::ostream* os;
+    const LabelRegistry& labels;
+    std::size_t bufferSize;
+
+    std::mutex mu;
+    std::string buffer{};
+    std::size_t numEvents{ 0 };
+    std::vector< std::string > names{};
+    std::vector< bool > threadsSeen{};
+    bool closed{ false };
+};
+
+// start recording the spans of the collector into a trace file; the trace is completed when
+// the returned sink is closed or, at the latest, when the collector is destroyed at exit
+inline std::shared_ptr< ChromeTraceSink > traceTo( const std::string& path,
+                                                    SpanCollector& collector
+                                                    = SpanCollector::instance() )
+{
+    auto sink = std::make_shared< ChromeTraceSink >( path, collector.labels() );
+    collector.addSink( sink );
+    return sink;
+}
+
+}  // namespace AutoTimer::Spans
+
+#endif  // AUTOTIMER_CHROME_TRACE_HH
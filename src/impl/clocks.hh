@@ -0,0 +1,201 @@
+//
+// Created by weining on 18/10/26.
+//
+
+#ifndef AUTOTIMER_CLOCKS_HH
+#define AUTOTIMER_CLOCKS_HH
+
+#include "time_record.hh"
+
+#include <chrono>
+#include <cstdint>
+#include <type_traits>
+
+#if defined( __x86_64__ ) || defined( __i386__ )
+#include <cpuid.h>
+#include <x86intrin.h>
+#define AUTOTIMER_HAS_TSC 1
+#else
+#define AUTOTIMER_HAS_TSC 0
+#endif
+
+namespace AutoTimer
+{
+using DefaultClock = std::chrono::high_resolution_clock;
+
+// reads the invariant time-stamp counter and converts ticks to nanoseconds with a factor
+// calibrated against steady_clock on first use; falls back to steady_clock when the CPU does
+// not advertise an invariant TSC
+struct TscClock
+{
+    using rep = TimeRecord::Duration::rep;
+    using period = TimeRecord::Duration::period;
+    using duration = TimeRecord::Duration;
+    using time_point = std::chrono::time_point< TscClock >;
+    static constexpr bool is_steady = true;
+
+    struct Calibration
+    {
+        bool invariant{ false };
+        std::uint64_t baseTicks{};
+        double nsPerTick{ 1.0 };
+    };
+
+    static bool hasInvariantTsc()
+    {
+#if AUTOTIMER_HAS_TSC
+        unsigned a{}, b{}, c{}, d{};
+        if ( __get_cpuid_max( 0x80000000, nullptr ) < 0x80000007 )
+        {
+            return false;
+        }
+        __get_cpuid( 0x80000007, &a, &b, &c, &d );
+        return ( d & ( 1u << 8 ) ) != 0;
+#else
+        return false;
+#endif
+    }
+
+    // spins for the given window and relates the tick delta to the steady_clock delta
+    static Calibration calibrate(
+        std::chrono::milliseconds window = std::chrono::milliseconds( 20 ) )
+    {
+        Calibration cal{};
+        cal.invariant = hasInvariantTsc();
+        if ( !cal.invariant )
+        {
+            return cal;
+        }
+        auto t0 = std::chrono::steady_clock::now();
+        auto c0 = readTicks();
+        auto t1 = t0;
+        while ( t1 - t0 < window )
+        {
+            t1 = std::chrono::steady_clock::now();
+        }
+        auto c1 = readTicks();
+        auto ns = std::chrono::duration_cast< std::chrono::nanoseconds >( t1 - t0 ).count();
+        cal.baseTicks = c0;
+        cal.nsPerTick = static_cast< double >( ns ) / static_cast< double >( c1 - c0 );
+        return cal;
+    }
+
+    static const Calibration& calibration()
+    {
+        static const Calibration cal = calibrate();
+        return cal;
+    }
+
+    static time_point now() noexcept
+    {
+        return fromTicks( readTicks() );
+    }
+
+    // fenced reads for the edges of a measured region: start() keeps earlier instructions from
+    // drifting past the read, stop() waits for the measured instructions to retire
+    static time_point start() noexcept
+    {
+        const auto& cal = calibration();
+        if ( !cal.invariant )
+        {
+            return fromSteady();
+        }
+#if AUTOTIMER_HAS_TSC
+        _mm_lfence();
+        auto ticks = __rdtsc();
+        _mm_lfence();
+        return fromTicks( ticks );
+#else
+        return fromSteady();
+#endif
+    }
+
+    static time_point stop() noexcept
+    {
+        const auto& cal = calibration();
+        if ( !cal.invariant )
+        {
+            return fromSteady();
+        }
+#if AUTOTIMER_HAS_TSC
+        unsigned aux{};
+        auto ticks = __rdtscp( &aux );
+        _mm_lfence();
+        return fromTicks( ticks );
+#else
+        return fromSteady();
+#endif
+    }
+
+private:
+    static std::uint64_t readTicks() noexcept
+    {
+#if AUTOTIMER_HAS_TSC
+        return __rdtsc();
+#else
+        return 0;
+#endif
+    }
+
+    static time_point fromSteady() noexcept
+    {
+        return time_point( std::chrono::duration_cast< duration >(
+            std::chrono::steady_clock::now().time_since_epoch() ) );
+    }
+
+    static time_point fromTicks( std::uint64_t ticks ) noexcept
+    {
+        const auto& cal = calibration();
+        if ( !cal.invariant )
+        {
+            return fromSteady();
+        }
+        auto elapsed = static_cast< double >( static_cast< std::int64_t >( ticks - cal.baseTicks ) )
+                       * cal.nsPerTick;
+        return time_point( duration( static_cast< rep >( elapsed ) ) );
+    }
+};
+
+namespace Impl
+{
+template < typename Clock, typename = void >
+struct HasFencedReads : std::false_type
+{
+};
+
+template < typename Clock >
+struct HasFencedReads< Clock, std::void_t< decltype( Clock::start() ), decltype( Clock::stop() ) > >
+    : std::true_type
+{
+};
+
+template < typename Clock >
+typename Clock::time_point sampleStart() noexcept
+{
+    if constexpr ( HasFencedReads< Clock >::value )
+    {
+        return Clock::start();
+    }
+    else
+    {
+        return Clock::now();
+    }
+}
+
+template < typename Clock >
+typename Clock::time_point sampleStop() noexcept
+{
+    if constexpr ( HasFencedReads< Clock >::value )
+    {
+        return Clock::stop();
+    }
+    else
+    {
+        return Clock::now();
+    }
+}
+}  // namespace Impl
+
+}  // namespace AutoTimer
+
+#endif  // AUTOTIMER_CLOCKS_HH
@@ -7,18 +7,25 @@
 
 #include "time_record.hh"
 
+#include <cmath>
+#include <cstdint>
 #include <iostream>
 #include <iomanip>
+#include <limits>
+#include <sstream>
+#include <string>
 #include <tuple>
+#include <type_traits>
+#include <vector>
 
 namespace AutoTimer
 {
 using namespace TimeRecord;
 
-std::ostream& renderCastedSummary( std::ostream& os,
-                                   size_t indent,
-                                   AutoTimer::TimeUnitOptions opt,
-                                   const SummaryCasted& summary )
+inline std::ostream& renderCastedSummary( std::ostream& os,
+                                          size_t indent,
+                                          AutoTimer::TimeUnitOptions opt,
+                                          const SummaryCasted& summary )
 {
     std::string label{};
     if ( std::get< 0 >( summary ).empty() )
@@ -55,6 +62,130 @@ std::ostream& renderCastedSummary( std::ostream& os,
     return os;
 }
 
+inline std::ostream& renderStatistics( std::ostream& os,
+                                       size_t indent,
+                                       AutoTimer::TimeUnitOptions opt,
+                                       const Statistics& s )
+{
+    auto c = [ opt ]( Duration d ) { return castDuration( d, opt ); };
+    os << std::string( indent, ' ' ) << "median: " << c( s.median ) << ", p90: " << c( s.p90 )
+       << ", p99: " << c( s.p99 ) << ", p99.9: " << c( s.p999 ) << ", stddev: " << c( s.stddev )
+       << ", mad: " << c( s.mad );
+    if ( s.meanInterval.upper.count() )
+    {
+        os << ", 95% CI mean: [" << c( s.meanInterval.lower ) << ", " << c( s.meanInterval.upper )
+           << "], median: [" << c( s.medianInterval.lower ) << ", "
+           << c( s.medianInterval.upper ) << ']';
+    }
+    return os;
+}
+
+inline std::ostream& renderCounters( std::ostream& os, size_t indent, const Counters& c )
+{
+    auto precision = os.precision();
+    os << std::string( indent, ' ' ) << "per op:" << std::fixed << std::setprecision( 2 );
+    const char* separator = " ";
+    if ( c.ipc() > 0 )
+    {
+        os << separator << "IPC: " << c.ipc();
+        separator = ", ";
+    }
+    for ( size_t e = 0; e < Counters::EventCount; ++e )
+    {
+        if ( c.available[ e ] )
+        {
+            os << separator << Counters::name( e ) << ": " << c.perOp[ e ];
+            separator = ", ";
+        }
+    }
+    os << std::defaultfloat << std::setprecision( static_cast< int >( precision ) );
+    return os;
+}
+
+// what the harness knows about a record beyond its summary, closing the record's line and
+// putting the distribution (for more than one run) on an indented line below it
+inline std::ostream& renderRecordDetails( std::ostream& os,
+                                          size_t indent,
+                                          AutoTimer::TimeUnitOptions opt,
+                                          const RecordMultiDim<>& record )
+{
+    if ( record.batch > 1 )
+    {
+        os << " batch: " << record.batch << " (per batch: " << record.batchMin.count() << " - "
+           << record.batchMax.count() << " nano)";
+    }
+    if ( record.contention.threads )
+    {
+        auto precision = os.precision();
+        os << " threads: " << record.contention.threads << " (" << std::fixed
+           << std::setprecision( 0 ) << record.contention.opsPerSecond << " ops/s, efficiency: "
+           << std::setprecision( 2 ) << record.contention.efficiency << ')' << std::defaultfloat
+           << std::setprecision( static_cast< int >( precision ) );
+    }
+    if ( record.cpu >= 0 )
+    {
+        os << " [cpu " << record.cpu << ']';
+    }
+    if ( record.warmupRuns )
+    {
+        os << " warmup: " << record.warmupRuns;
+    }
+    if ( record.outliers.mild() || record.outliers.severe() )
+    {
+        os << " outliers: " << record.outliers.mild() << " mild, " << record.outliers.severe()
+           << " severe";
+    }
+    if ( record.overhead.count() )
+    {
+        os << " overhead: " << record.overhead.count() << " nano";
+    }
+    if ( record.nearNoiseFloor )
+    {
+        os << " (warning: close to the timer overhead)";
+    }
+    if ( !record.converged )
+    {
+        os << " (warning: target precision not reached)";
+    }
+    os << '\n';
+    if ( std::get< 1 >( record.summary ) > 1 )
+    {
+        renderStatistics( os, indent + 4, opt, record.statistics ) << '\n';
+    }
+    if ( record.counters.any() )
+    {
+        renderCounters( os, indent + 4, record.counters ) << '\n';
+    }
+    if ( record.allocations.tracked )
+    {
+        const auto& a = record.allocations;
+        auto precision = os.precision();
+        os << std::string( indent + 4, ' ' ) << std::fixed << std::setprecision( 2 )
+           << "allocations per op: " << a.allocations << " (" << a.bytes
+           << " bytes), frees: " << a.frees << std::defaultfloat
+           << std::setprecision( static_cast< int >( precision ) ) << '\n';
+    }
+    if ( !record.histogram.empty() )
+    {
+        const auto& h = record.histogram;
+        os << std::string( indent + 4, ' ' ) << "histogram: p99.99: "
+           << castDuration( h.valueAtPercentile( 99.99 ), opt ) << ", p99.999: "
+           << castDuration( h.valueAtPercentile( 99.999 ), opt )
+           << ", max: " << castDuration( h.max(), opt ) << " (" << h.count() << " samples, "
+           << h.significantDigits() << " digits, " << h.buckets().size() << " buckets)\n";
+    }
+    if ( record.contention.threads > 1 )
+    {
+        os << std::string( indent + 4, ' ' ) << "per thread:";
+        for ( auto d : record.contention.perThread )
+        {
+            os << ' ' << castDuration( d, opt );
+        }
+        os << '\n';
+    }
+    return os;
+}
+
 template < typename... Ts >
 std::ostream& render( std::ostream& os,
                       size_t indent,
@@ -86,35 +217,292 @@ std::ostream& render( std::ostream& os,
                 os << std::string( indent, ' ' );
                 os << record.label << "(" << parameter << ") ";
                 auto castedSummary = field.castSummary( opt );
-                renderCastedSummary( os, 0, opt, castedSummary ) << '\n';
+                renderCastedSummary( os, 0, opt, castedSummary );
+                renderRecordDetails( os, indent, opt, field );
             }
         }
         else
         {
             auto castedSummary = record.castSummary( opt );
-            renderCastedSummary( os, indent, opt, castedSummary ) << '\n';
+            renderCastedSummary( os, indent, opt, castedSummary );
+            renderRecordDetails( os, indent, opt, record );
         }
     }
     return os;
 }
 
-template < typename... Ts >
-struct Report
+// the scaling parameters leading to a record, outermost first
+struct Coordinate
 {
     std::string label{};
-    std::vector< RecordMultiDim< Ts... > > timeRecords{};
+    std::string value{};
+    bool numeric{ false };
+    // false for an infinite or NaN floating point value, which JSON has no number for
+    bool finite{ true };
+};
+
+using Coordinates = std::vector< Coordinate >;
+
+// a scaling parameter as the exporters write it; characters are written as their codes and
+// floating point values keep all their digits
+template < typename T >
+Coordinate makeCoordinate( const std::string& label, const T& value )
+{
+    Coordinate c{ label, {}, std::is_arithmetic_v< T > };
+    std::ostringstream oss;
+    if constexpr ( std::is_floating_point_v< T > )
+    {
+        oss << std::setprecision( std::numeric_limits< T >::max_digits10 );
+        c.finite = std::isfinite( value );
+    }
+    if constexpr ( std::is_same_v< T, char > || std::is_same_v< T, signed char >
+                   || std::is_same_v< T, unsigned char > )
+    {
+        oss << static_cast< int >( value );
+    }
+    else
+    {
+        oss << value;
+    }
+    c.value = oss.str();
+    return c;
+}
+
+// flatten a record tree: call visit( coordinates, leaf ) for every leaf in order
+template < typename Visitor >
+void forEachLeaf( const RecordMultiDim<>& record, Coordinates& coordinates, Visitor&& visit )
+{
+    visit( static_cast< const Coordinates& >( coordinates ), record );
+}
 
-    std::ostream& formatted( std::ostream& os,
-                             AutoTimer::TimeUnitOptions opt,
-                             const std::string& entryIndent ) const
+template < typename T, typename... Ts, typename Visitor >
+void forEachLeaf( const RecordMultiDim< T, Ts... >& record,
+                  Coordinates& coordinates,
+                  Visitor&& visit )
+{
+    for ( const auto& [ parameter, field ] : record.fields )
     {
-        os << label << '\n';
-        for ( const auto& timeRecord : timeRecords )
+        coordinates.push_back( makeCoordinate( record.label, parameter ) );
+        forEachLeaf( field, coordinates, visit );
+        coordinates.pop_back();
+    }
+}
+
+inline std::ostream& writeJsonString( std::ostream& os, const std::string& s )
+{
+    os << '"';
+    for ( auto c : s )
+    {
+        if ( c == '"' || c == '\\' )
+        {
+            os << '\\' << c;
+        }
+        else if ( c == '\n' )
         {
-            render( os, 4, opt, timeRecord );
+            os << "\\n";
+        }
+        else if ( static_cast< unsigned char >( c ) < 0x20 )
+        {
+            os << "\\u" << std::hex << std::setw( 4 ) << std::setfill( '0' ) << int( c )
+               << std::dec << std::setfill( ' ' );
+        }
+        else
+        {
+            os << c;
         }
-        return os;
     }
-};
+    return os << '"';
+}
+
+// all the digits needed to read the same double back, null where JSON has no number
+inline std::ostream& writeJsonNumber( std::ostream& os, double x )
+{
+    if ( std::isfinite( x ) )
+    {
+        auto precision = os.precision( std::numeric_limits< double >::max_digits10 );
+        os << x;
+        os.precision( precision );
+    }
+    else
+    {
+        os << "null";
+    }
+    return os;
+}
+
+// one record as a JSON object: its coordinates, summary, distribution and whatever else the
+// harness measured; durations in nanoseconds
+inline std::ostream& writeJsonRecord( std::ostream& os,
+                                      const Coordinates& coordinates,
+                                      const RecordMultiDim<>& r )
+{
+    const auto& s = r.statistics;
+    os << "{\"measure\": ";
+    writeJsonString( os, r.label().empty() ? "measure" : r.label() );
+    os << ", \"parameters\": {";
+    for ( size_t i = 0; i < coordinates.size(); ++i )
+    {
+        writeJsonString( os << ( i ? ", " : "" ), coordinates[ i ].label ) << ": ";
+        if ( coordinates[ i ].numeric && !coordinates[ i ].finite )
+        {
+            os << "null";
+        }
+        else if ( coordinates[ i ].numeric )
+        {
+            os << coordinates[ i ].value;
+        }
+        else
+        {
+            writeJsonString( os, coordinates[ i ].value );
+        }
+    }
+    os << "}, \"runs\": " << std::get< 1 >( r.summary )
+       << ", \"mean_ns\": " << std::get< 2 >( r.summary ).count()
+       << ", \"min_ns\": " << std::get< 3 >( r.summary ).count()
+       << ", \"max_ns\": " << std::get< 4 >( r.summary ).count()
+       << ", \"median_ns\": " << s.median.count() << ", \"p90_ns\": " << s.p90.count()
+       << ", \"p99_ns\": " << s.p99.count() << ", \"p999_ns\": " << s.p999.count()
+       << ", \"stddev_ns\": " << s.stddev.count() << ", \"mad_ns\": " << s.mad.count()
+       << ", \"mean_ci_ns\": [" << s.meanInterval.lower.count() << ", "
+       << s.meanInterval.upper.count() << "], \"median_ci_ns\": ["
+       << s.medianInterval.lower.count() << ", " << s.medianInterval.upper.count()
+       << "], \"batch\": " << r.batch << ", \"overhead_ns\": " << r.overhead.count()
+       << ", \"warmup_runs\": " << r.warmupRuns << ", \"outliers\": {\"mild\": "
+       << r.outliers.mild() << ", \"severe\": " << r.outliers.severe()
+       << "}, \"converged\": " << ( r.converged ? "true" : "false" );
+    if ( r.cpu >= 0 )
+    {
+        os << ", \"cpu\": " << r.cpu;
+    }
+    if ( r.contention.threads )
+    {
+        os << ", \"threads\": " << r.contention.threads << ", \"ops_per_second\": ";
+        writeJsonNumber( os, r.contention.opsPerSecond ) << ", \"efficiency\": ";
+        writeJsonNumber( os, r.contention.efficiency );
+    }
+    if ( r.counters.any() )
+    {
+        os << ", \"counters_per_op\": {";
+        const char* separator = "";
+        for ( size_t e = 0; e < Counters::EventCount; ++e )
+        {
+            if ( r.counters.available[ e ] )
+            {
+                writeJsonString( os << separator, Counters::name( e ) ) << ": ";
+                writeJsonNumber( os, r.counters.perOp[ e ] );
+                separator = ", ";
+            }
+        }
+        os << '}';
+    }
+    if ( r.allocations.tracked )
+    {
+        os << ", \"allocations_per_op\": {\"allocations\": ";
+        writeJsonNumber( os, r.allocations.allocations ) << ", \"frees\": ";
+        writeJsonNumber( os, r.allocations.frees ) << ", \"bytes\": ";
+        writeJsonNumber( os, r.allocations.bytes ) << '}';
+    }
+    if ( !r.histogram.empty() )
+    {
+        os << ", \"histogram\": {\"significant_digits\": " << r.histogram.significantDigits()
+           << ", \"count\": " << r.histogram.count() << ", \"buckets_ns\": [";
+        const char* separator = "";
+        r.histogram.forEachBucket( [ & ]( Duration lowest, std::uint64_t count ) {
+            os << separator << '[' << lowest.count() << ", " << count << ']';
+            separator = ", ";
+        } );
+        os << "]}";
+    }
+    if ( !r.samples.empty() )
+    {
+        os << ", \"samples_ns\": [";
+        for ( size_t i = 0; i < r.samples.size(); ++i )
+        {
+            os << ( i ? ", " : "" ) << r.samples[ i ].count();
+        }
+        os << ']';
+    }
+    return os << '}';
+}
+
+// the CSV columns after the measure label and the coordinates
+inline const char* csvColumns()
+{
+    return "runs,mean_ns,min_ns,max_ns,median_ns,p90_ns,p99_ns,p999_ns,stddev_ns,mad_ns,"
+           "mean_ci_lower_ns,mean_ci_upper_ns,batch,overhead_ns,outliers_mild,outliers_severe,"
+           "converged,cpu,threads,ops_per_second,efficiency,cycles_per_op,instructions_per_op,"
+           "branch_misses_per_op,l1d_misses_per_op,llc_misses_per_op,dtlb_misses_per_op,"
+           "task_clock_ns_per_op,page_faults_per_op,context_switches_per_op,allocations_per_op,"
+           "frees_per_op,bytes_per_op,samples_ns";
+}
+
+// quoted when it contains a separator, a quote or a line break
+inline std::ostream& writeCsvField( std::ostream& os, const std::string& s )
+{
+    if ( s.find_first_of( ",\"\n" ) == std::string::npos )
+    {
+        return os << s;
+    }
+    os << '"';
+    for ( auto c : s )
+    {
+        os << ( c == '"' ? "\"\"" : std::string( 1, c ) );
+    }
+    return os << '"';
+}
+
+// one record as a CSV line; what was not measured (e.g. the counters without
+// withPerfCounters()) is left empty, and the raw samples (if kept) go into the last column,
+// space separated
+inline std::ostream& writeCsvRecord( std::ostream& os,
+                                     const Coordinates& coordinates,
+                                     const RecordMultiDim<>& r )
+{
+    const auto& s = r.statistics;
+    writeCsvField( os, r.label().empty() ? "measure" : r.label() );
+    for ( const auto& coordinate : coordinates )
+    {
+        writeCsvField( os << ',', coordinate.value );
+    }
+    os << ',' << std::get< 1 >( r.summary ) << ',' << std::get< 2 >( r.summary ).count() << ','
+       << std::get< 3 >( r.summary ).count() << ',' << std::get< 4 >( r.summary ).count() << ','
+       << s.median.count() << ',' << s.p90.count() << ',' << s.p99.count() << ','
+       << s.p999.count() << ',' << s.stddev.count() << ',' << s.mad.count() << ','
+       << s.meanInterval.lower.count() << ',' << s.meanInterval.upper.count() << ',' << r.batch
+       << ',' << r.overhead.count() << ',' << r.outliers.mild() << ',' << r.outliers.severe()
+       << ',' << ( r.converged ? "true" : "false" ) << ',';
+    auto number = [ &os ]( bool available, double x ) -> std::ostream& {
+        if ( available && std::isfinite( x ) )
+        {
+            writeJsonNumber( os, x );
+        }
+        return os << ',';
+    };
+    if ( r.cpu >= 0 )
+    {
+        os << r.cpu;
+    }
+    os << ',';
+    auto contended = r.contention.threads > 0;
+    if ( contended )
+    {
+        os << r.contention.threads;
+    }
+    os << ',';
+    number( contended, r.contention.opsPerSecond );
+    number( contended, r.contention.efficiency );
+    for ( size_t e = 0; e < Counters::EventCount; ++e )
+    {
+        number( r.counters.available[ e ], r.counters.perOp[ e ] );
+    }
+    number( r.allocations.tracked, r.allocations.allocations );
+    number( r.allocations.tracked, r.allocations.frees );
+    number( r.allocations.tracked, r.allocations.bytes );
+    for ( size_t i = 0; i < r.samples.size(); ++i )
+    {
+        os << ( i ? " " : "" ) << r.samples[ i ].count();
+    }
+    return os << '\n';
+}
 }  // namespace AutoTimer
 #endif  // AUTOTIMER_EXPORT_HH
@@ -0,0 +1,279 @@
+//
+// Created by weining on 18/10/26.
+//
+
+#ifndef AUTOTIMER_HISTOGRAM_HH
+#define AUTOTIMER_HISTOGRAM_HH
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace AutoTimer::Hdr
+{
+// the same representation as TimeRecord::Duration
+using Nanoseconds = std::chrono::duration< long, std::ratio< 1, 1000000000 > >;
+
+inline int highestBit( std::uint64_t x )
+{
+#if defined( __GNUC__ ) || defined( __clang__ )
+    return 63 - __builtin_clzll( x );
+#else
+    int bit{ -1 };
+    while ( x )
+    {
+        x >>= 1;
+        ++bit;
+    }
+    return bit;
+#endif
+}
+
+// an HDR histogram of durations: values are counted in buckets whose width grows with the value
+// so that every value is kept to the given number of significant decimal digits, from 1 nano up
+// to `highest` (larger values count as `highest`). The memory is bounded by the precision and
+// the range, not by the number of values; the buckets are allocated up to the largest value
+// recorded so far. Histograms of the same precision merge exactly, e.g. across threads or runs
+class Histogram
+{
+public:
+    static constexpr int maxSignificantDigits = 5;
+
+    explicit Histogram( int significantDigits = 2, Nanoseconds highest = std::chrono::hours( 1 ) )
+        : digits( std::clamp( significantDigits, 1, maxSignificantDigits ) ),
+          highestValue( std::max< std::uint64_t >( highest.count(), 2 ) )
+    {
+        auto largestSingleUnit = 2 * static_cast< std::uint64_t >( std::pow( 10, digits ) );
+        subBucketHalfCountMagnitude = highestBit( largestSingleUnit - 1 );
+        subBucketHalfCount = std::uint64_t{ 1 } << subBucketHalfCountMagnitude;
+        subBucketMask = ( subBucketHalfCount << 1 ) - 1;
+    }
+
+    void record( Nanoseconds d, std::uint64_t times = 1 )
+    {
+        auto value = std::min< std::uint64_t >( std::max< long >( d.count(), 0 ), highestValue );
+        auto index = indexOf( value );
+        if ( index >= counts.size() )
+        {
+            counts.resize( index + 1 );
+        }
+        counts[ index ] += times;
+        total += times;
+        lowest = std::min( lowest, value );
+        largest = std::max( largest, value );
+    }
+
+    // add the other histogram's counts; one of a different precision is re-recorded at the
+    // midpoints of its buckets
+    Histogram& merge( const Histogram& other )
+    {
+        if ( other.digits == digits && other.highestValue == highestValue )
+        {
+            if ( other.counts.size() > counts.size() )
+            {
+                counts.resize( other.counts.size() );
+            }
+            for ( size_t i = 0; i < other.counts.size(); ++i )
+            {
+                counts[ i ] += other.counts[ i ];
+            }
+            total += other.total;
+            lowest = std::min( lowest, other.lowest );
+            largest = std::max( largest, other.largest );
+            return *this;
+        }
+        for ( size_t i = 0; i < other.counts.size(); ++i )
+        {
+            if ( other.counts[ i ] )
+            {
+                auto lo = other.valueAt( i );
+                auto hi = lo + other.widthAt( i ) - 1;
+                record( Nanoseconds( static_cast< long >( lo + ( hi - lo ) / 2 ) ),
+                        other.counts[ i ] );
+            }
+        }
+        return *this;
+    }
+
+    [[nodiscard]] bool empty() const
+    {
+        return total == 0;
+    }
+
+    [[nodiscard]] std::uint64_t count() const
+    {
+        return total;
+    }
+
+    [[nodiscard]] int significantDigits() const
+    {
+        return digits;
+    }
+
+    [[nodiscard]] Nanoseconds highest() const
+    {
+        return Nanoseconds( static_cast< long >( highestValue ) );
+    }
+
+    [[nodiscard]] Nanoseconds min() const
+    {
+        return Nanoseconds( total ? static_cast< long >( lowest ) : 0 );
+    }
+
+    [[nodiscard]] Nanoseconds max() const
+    {
+        return Nanoseconds( static_cast< long >( largest ) );
+    }
+
+    // the smallest value (to the histogram's precision) that at least the given percentage of
+    // the recorded values do not exceed
+    [[nodiscard]] Nanoseconds valueAtPercentile( double percentile ) const
+    {
+        if ( total == 0 )
+        {
+            return {};
+        }
+        auto fraction = std::clamp( percentile, 0.0, 100.0 ) / 100.0;
+        auto wanted = std::max< std::uint64_t >(
+            static_cast< std::uint64_t >( std::ceil( fraction * static_cast< double >( total ) ) ),
+            1 );
+        std::uint64_t seen{ 0 };
+        for ( size_t i = 0; i < counts.size(); ++i )
+        {
+            seen += counts[ i ];
+            if ( seen >= wanted )
+            {
+                auto highestEquivalent = valueAt( i ) + widthAt( i ) - 1;
+                return Nanoseconds(
+                    static_cast< long >( std::clamp( highestEquivalent, lowest, largest ) ) );
+            }
+        }
+        return max();
+    }
+
+    [[nodiscard]] Nanoseconds mean() const
+    {
+        if ( total == 0 )
+        {
+            return {};
+        }
+        double sum{ 0 };
+        for ( size_t i = 0; i < counts.size(); ++i )
+        {
+            sum += static_cast< double >( counts[ i ] )
+                   * ( static_cast< double >( valueAt( i ) )
+                       + static_cast< double >( widthAt( i ) - 1 ) / 2 );
+        }
+        return Nanoseconds( static_cast< long >( sum / static_cast< double >( total ) ) );
+    }
+
+    // call visit( lowest value, count ) for every non-empty bucket, in increasing order
+    template < typename Visitor >
+    void forEachBucket( Visitor&& visit ) const
+    {
+        for ( size_t i = 0; i < counts.size(); ++i )
+        {
+            if ( counts[ i ] )
+            {
+                visit( Nanoseconds( static_cast< long >( valueAt( i ) ) ), counts[ i ] );
+            }
+        }
+    }
+
+    // the raw counts, indexed by bucket
+    [[nodiscard]] const std::vector< std::uint64_t >& buckets() const
+    {
+        return counts;
+    }
+
+    // call visit( index, count ) for every non-empty bucket; restore() takes them back, e.g.
+    // from a ResultStore
+    template < typename Visitor >
+    void forEachCount( Visitor&& visit ) const
+    {
+        for ( size_t i = 0; i < counts.size(); ++i )
+        {
+            if ( counts[ i ] )
+            {
+                visit( i, counts[ i ] );
+            }
+        }
+    }
+
+    // the histogram of the n buckets at the given (ascending) indices and with the given counts
+    void restore( const std::uint32_t* indices, const std::uint64_t* bucketCounts, size_t n )
+    {
+        counts.assign( n ? indices[ n - 1 ] + size_t{ 1 } : 0, 0 );
+        for ( size_t i = 0; i < n; ++i )
+        {
+            counts[ indices[ i ] ] = bucketCounts[ i ];
+        }
+        total = 0;
+        lowest = UINT64_MAX;
+        largest = 0;
+        for ( size_t i = 0; i < counts.size(); ++i )
+        {
+            if ( counts[ i ] )
+            {
+                total += counts[ i ];
+                lowest = std::min( lowest, valueAt( i ) );
+                largest = std::max( largest, valueAt( i ) + widthAt( i ) - 1 );
+            }
+        }
+        largest = std::min( largest, highestValue );
+    }
+
+    void reset()
+    {
+        counts.clear();
+        total = 0;
+        lowest = UINT64_MAX;
+        largest = 0;
+    }
+
+private:
+    // values below 2 * subBucketHalfCount have a bucket each; above, every doubling of the
+    // value gets subBucketHalfCount buckets, twice as wide as those of the previous doubling
+    [[nodiscard]] size_t indexOf( std::uint64_t value ) const
+    {
+        auto magnitude = highestBit( value | subBucketMask ) - subBucketHalfCountMagnitude;
+        return static_cast< size_t >(
+            ( static_cast< std::uint64_t >( magnitude ) << subBucketHalfCountMagnitude )
+            + ( value >> magnitude ) );
+    }
+
+    [[nodiscard]] int magnitudeAt( size_t index ) const
+    {
+        return std::max( static_cast< int >( index >> subBucketHalfCountMagnitude ) - 1, 0 );
+    }
+
+    [[nodiscard]] std::uint64_t valueAt( size_t index ) const
+    {
+        auto magnitude = magnitudeAt( index );
+        return ( index - ( static_cast< std::uint64_t >( magnitude )
+                           << subBucketHalfCountMagnitude ) )
+               << magnitude;
+    }
+
+    [[nodiscard]] std::uint64_t widthAt( size_t index ) const
+    {
+        return std::uint64_t{ 1 } << magnitudeAt( index );
+    }
+
+    int digits;
+    std::uint64_t highestValue;
+    int subBucketHalfCountMagnitude{};
+    std::uint64_t subBucketHalfCount{};
+    std::uint64_t subBucketMask{};
+
+    std::vector< std::uint64_t > counts{};
+    std::uint64_t total{ 0 };
+    std::uint64_t lowest{ UINT64_MAX };
+    std::uint64_t largest{ 0 };
+};
+
+}  // namespace AutoTimer::Hdr
+
+#endif  // AUTOTIMER_HISTOGRAM_HH
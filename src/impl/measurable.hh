@@ -5,11 +5,23 @@
 #ifndef AUTOTIMER_MEASURABLE_HH
 #define AUTOTIMER_MEASURABLE_HH
 
+#include "allocations.hh"
+#include "barrier.hh"
+#include "clocks.hh"
+#include "histogram.hh"
+#include "optimizer.hh"
+#include "perf_counters.hh"
+#include "statistics.hh"
 #include "tasks.hh"
 #include "time_record.hh"
 
+#include <algorithm>
+#include <functional>
+#include <memory>
 #include <numeric>
 #include <optional>
+#include <thread>
+#include <type_traits>
 
 namespace AutoTimer
 {
@@ -17,61 +29,623 @@ namespace Impl
 {
 using namespace TimeRecord;
 
-template < typename... Ts >
-struct Measurable
+// the timed loop, compiled against the concrete type of the subject so the call can be
+// inlined; only the loop as a whole is called through the virtual interface. A subject that
+// returns a value has it sunk through doNotOptimize(), one that does not is followed by
+// clobberMemory(), so the work behind it is kept and not folded across the batch
+template < typename Clock, typename... Ts >
+struct SampleLoop
+{
+    // each of the n samples times `batch` back-to-back invocations
+    virtual void sample( Duration* ds, size_t n, size_t batch, Ts&... args ) const = 0;
+    virtual ~SampleLoop() = default;
+};
+
+template < typename Clock, typename Function, typename... Ts >
+struct ConcreteSampleLoop : public SampleLoop< Clock, Ts... >
+{
+    mutable Function f;
+
+    explicit ConcreteSampleLoop( Function fn ) : f( std::move( fn ) )
+    {
+    }
+
+    void sample( Duration* ds, size_t n, size_t batch, Ts&... args ) const override
+    {
+        for ( size_t i = 0; i < n; ++i )
+        {
+            auto begin = sampleStart< Clock >();
+            for ( size_t k = 0; k < batch; ++k )
+            {
+                if constexpr ( std::is_void_v< std::invoke_result_t< Function&, Ts&... > > )
+                {
+                    f( args... );
+                    clobberMemory();
+                }
+                else
+                {
+                    doNotOptimize( f( args... ) );
+                }
+            }
+            ds[ i ] = std::chrono::duration_cast< Duration >( sampleStop< Clock >() - begin );
+        }
+    }
+};
+
+template < typename Clock, typename... Ts >
+struct BasicMeasurable
 {
     std::optional< TaskMultiDim< Ts... > > init{};
-    std::optional< TaskMultiDim< Ts... > > subject{};
+    // run around every sample with the clock stopped; setup is told how many invocations the
+    // sample is going to make (the batch size)
+    std::optional< std::function< void( size_t, Ts... ) > > setup{};
+    std::optional< TaskMultiDim< Ts... > > teardown{};
+    std::shared_ptr< const SampleLoop< Clock, Ts... > > subject{};
     size_t multiplier{ 1 };
     std::string label{};
+    bool subtractOverhead{ false };
+    size_t batch{ 1 };
+    std::optional< Duration > batchTarget{};
+    size_t bootstrapResamples{ 0 };
+    std::optional< double > targetPrecision{};
+    std::optional< Duration > timeBudget{};
+    size_t warmup{ 0 };
+    bool warmupUntilStable{ false };
+    OutlierRejection outlierRejection{ OutlierRejection::None };
+    // 0 measures on the calling thread, otherwise on this many threads at once
+    size_t threads{ 0 };
+    // the (integral) argument carrying the thread count, e.g. a "threads" scaling parameter
+    std::optional< size_t > threadsArgument{};
+    bool perfCounters{ false };
+    bool trackAllocations{ false };
+    bool keepSamples{ false };
+    // the significant digits of the record's histogram, none without
+    std::optional< int > histogramDigits{};
 
-    Measurable() = delete;
+    BasicMeasurable() = delete;
 
-    explicit Measurable( const TaskMultiDim< Ts... >& t ) : subject( t )
+    // keeps the concrete type of the callable (lambda, function object or TaskMultiDim);
+    // copies share it
+    template < typename Function,
+               typename = std::enable_if_t<
+                   !std::is_same_v< std::decay_t< Function >, BasicMeasurable > > >
+    explicit BasicMeasurable( Function&& f )
+        : subject( std::make_shared< ConcreteSampleLoop< Clock, std::decay_t< Function >, Ts... > >(
+            std::forward< Function >( f ) ) )
     {
     }
 
-    Measurable<Ts...>& withLabel( const std::string& s )
+    BasicMeasurable& withLabel( const std::string& s )
     {
         label = s;
         return *this;
     }
 
-    Measurable<Ts...>& withInit( const std::optional< TaskMultiDim< Ts... > >& t )
+    BasicMeasurable& withInit( const std::optional< TaskMultiDim< Ts... > >& t )
     {
         init = t;
         return *this;
     }
 
-    Measurable<Ts...>& withMultiplier( size_t mult )
+    // run before every sample, untimed; for mutating tasks such as sort or partition
+    BasicMeasurable& withSetup( const TaskMultiDim< Ts... >& t )
+    {
+        setup = [ t ]( size_t, Ts... args ) { t( args... ); };
+        return *this;
+    }
+
+    // run before every sample, untimed, with the number of invocations the sample will make, so
+    // that batched tiny tasks can consume one pre-built input per invocation
+    BasicMeasurable& withBatchSetup( const std::function< void( size_t, Ts... ) >& t )
+    {
+        setup = t;
+        return *this;
+    }
+
+    // run after every sample, untimed
+    BasicMeasurable& withTeardown( const TaskMultiDim< Ts... >& t )
+    {
+        teardown = t;
+        return *this;
+    }
+
+    BasicMeasurable& withMultiplier( size_t mult )
     {
         multiplier = mult;
         return *this;
     }
 
+    BasicMeasurable& withOverheadSubtraction( bool enabled = true )
+    {
+        subtractOverhead = enabled;
+        return *this;
+    }
+
+    // time k back-to-back invocations per sample and report the time per invocation
+    BasicMeasurable& withBatch( size_t k )
+    {
+        batch = std::max< size_t >( k, 1 );
+        batchTarget.reset();
+        return *this;
+    }
+
+    // choose the batch size so that one batch spans roughly the given duration
+    BasicMeasurable& withAutoBatch( Duration target = std::chrono::microseconds( 10 ) )
+    {
+        batchTarget = target;
+        return *this;
+    }
+
+    // report 95% confidence intervals from this many bootstrap resamples, 0 (the default)
+    // disables them; each resample redraws all the samples and selects their median
+    BasicMeasurable& withBootstrap( size_t resamples = 1000 )
+    {
+        bootstrapResamples = resamples;
+        return *this;
+    }
+
+    // keep sampling (beyond the multiplier, which becomes the minimum) until the 95% confidence
+    // interval of the mean is narrower than this fraction of the mean
+    BasicMeasurable& withTargetPrecision( double relativeWidth )
+    {
+        targetPrecision = relativeWidth;
+        return *this;
+    }
+
+    // keep sampling until the budget is spent, or stop early when the target precision is met
+    BasicMeasurable& withTimeBudget( Duration budget )
+    {
+        timeBudget = budget;
+        return *this;
+    }
+
+    // run (and discard) n samples before the measured ones
+    BasicMeasurable& withWarmup( size_t n )
+    {
+        warmup = n;
+        warmupUntilStable = false;
+        return *this;
+    }
+
+    // discard windows of samples until the medians of two consecutive windows agree within
+    // warmupTolerance, giving up after maxRuns samples
+    BasicMeasurable& withWarmupUntilStable( size_t maxRuns = 1000 )
+    {
+        warmup = maxRuns;
+        warmupUntilStable = true;
+        return *this;
+    }
+
+    // drop samples outside the Tukey fences from the summary; they are counted either way
+    BasicMeasurable& withOutlierRejection( OutlierRejection rejection )
+    {
+        outlierRejection = rejection;
+        return *this;
+    }
+
+    // run the task on n threads released together by a spin barrier, each taking `multiplier`
+    // samples; the summary pools the latencies of all threads and the record's contention
+    // reports the aggregate throughput and its efficiency against a single thread. The task and
+    // its routines must be thread-safe. The threads take a fixed number of uncounted samples:
+    // the perf counters, the allocation tracking, the target precision and the time budget do
+    // not apply (the builder rejects these combinations)
+    BasicMeasurable& withThreads( size_t n )
+    {
+        threads = n;
+        return *this;
+    }
+
+    // take the thread count from the given argument (see withThreads())
+    BasicMeasurable& withThreadsFromArgument( size_t index )
+    {
+        threadsArgument = index;
+        return *this;
+    }
+
+    // count hardware and software events (see Perf::CounterGroup) around the timed region of
+    // the measured samples and report them per invocation; not available with withThreads()
+    BasicMeasurable& withPerfCounters( bool enabled = true )
+    {
+        perfCounters = enabled;
+        return *this;
+    }
+
+    // count the heap allocations the task makes during the measured samples and report them
+    // per invocation; needs the tracking operator new/delete (see allocations.hh), and counts
+    // the calling thread only
+    BasicMeasurable& withAllocationTracking( bool enabled = true )
+    {
+        trackAllocations = enabled;
+        return *this;
+    }
+
+    // keep every measured sample in the record, e.g. for the exporters
+    BasicMeasurable& withRawSamples( bool enabled = true )
+    {
+        keepSamples = enabled;
+        return *this;
+    }
+
+    // count every measured sample into an HDR histogram kept in the record, which holds the
+    // whole distribution at a fixed memory however many samples are taken
+    BasicMeasurable& withHistogram( std::optional< int > significantDigits = 2 )
+    {
+        histogramDigits = significantDigits;
+        return *this;
+    }
+
     [[nodiscard]] Summary measure( Ts&&... args ) const
     {
-        if ( !subject.has_value() )
+        return measureRecord( std::forward< Ts >( args )... ).summary;
+    }
+
+    // the summary plus what the harness knows about it, e.g. its own overhead
+    [[nodiscard]] RecordMultiDim<> measureRecord( Ts&&... args ) const
+    {
+        RecordMultiDim<> r{};
+        if ( !subject )
         {
-            return {};
+            return r;
         }
+        auto started = std::chrono::steady_clock::now();
         if ( init.has_value() )
         {
-            init.value()( std::forward< Ts >( args )... );
+            init.value()( args... );
         }
 
-        std::vector< Duration > ds( multiplier );
-        for ( int i = 0; i < multiplier; ++i )
+        r.batch = batchTarget.has_value() ? chooseBatch( batchTarget.value(), args... ) : batch;
+        auto batchSize = static_cast< long >( r.batch );
+        r.overhead = measureOverhead( args... ) / batchSize;
+        r.warmupRuns = warmupUntilStable ? warmUpUntilStable( r.batch, args... )
+                                         : warmUp( r.batch, args... );
+        std::vector< Duration > ds;
+        if ( auto n = threadCount( args... ); n > 0 )
         {
-            auto begin = std::chrono::high_resolution_clock::now();
-            subject.value()( std::forward< Ts >( args )... );
-            ds[ i ] = std::chrono::high_resolution_clock::now() - begin;
+            ds = sampleContended( r, n, args... );
+        }
+        else
+        {
+            ds.resize( std::max< size_t >( multiplier, 1 ) );
+            if ( perfCounters || trackAllocations )
+            {
+                auto group = perfCounters ? std::make_unique< Perf::CounterGroup >() : nullptr;
+                Allocations::Counter allocations{};
+                sampleCounted( group.get(),
+                               trackAllocations ? &allocations : nullptr,
+                               ds.data(),
+                               ds.size(),
+                               r.batch,
+                               args... );
+                auto invocations = static_cast< double >( ds.size() * r.batch );
+                r.counters = group ? group->read( invocations ) : Counters{};
+                if ( trackAllocations )
+                {
+                    r.allocations = allocations.read( invocations );
+                }
+            }
+            else
+            {
+                sampleInto( ds.data(), ds.size(), r.batch, args... );
+            }
+            if ( targetPrecision.has_value() || timeBudget.has_value() )
+            {
+                r.converged = sampleAdaptively( ds, r.batch, started, args... );
+            }
+        }
+        if ( r.batch > 1 )
+        {
+            auto [ lo, hi ] = std::minmax_element( ds.cbegin(), ds.cend() );
+            r.batchMin = *lo;
+            r.batchMax = *hi;
+            for ( auto& d : ds )
+            {
+                d /= batchSize;
+            }
+        }
+        if ( subtractOverhead )
+        {
+            for ( auto& d : ds )
+            {
+                d = std::max( d - r.overhead, Duration{} );
+            }
+        }
+        if ( keepSamples )
+        {
+            r.samples = ds;
+        }
+        if ( histogramDigits.has_value() )
+        {
+            r.histogram = Hdr::Histogram( histogramDigits.value() );
+            for ( auto d : ds )
+            {
+                r.histogram.record( d );
+            }
         }
-        auto avg = std::accumulate( ds.cbegin(), ds.cend(), Duration{} ) / ds.size();
         std::sort( ds.begin(), ds.end() );
-        return std::make_tuple( label, multiplier, avg, ds.front(), ds.back() );
+        r.outliers = Stats::classifyOutliers( ds );
+        Stats::rejectOutliers( ds, outlierRejection );
+        auto avg = std::accumulate( ds.cbegin(), ds.cend(), Duration{} ) / ds.size();
+        r.statistics = Stats::describe( ds, bootstrapResamples );
+        r.nearNoiseFloor = r.statistics.median < r.overhead * noiseFloorFactor;
+        r.summary = std::make_tuple( label, ds.size(), avg, ds.front(), ds.back() );
+        return r;
     }
+
+    // the median cost of timing an empty task through the same harness
+    [[nodiscard]] Duration measureOverhead( Ts&... args ) const
+    {
+        static const ConcreteSampleLoop< Clock, EmptyTask, Ts... > empty{ EmptyTask{} };
+        std::vector< Duration > ds( calibrationRuns );
+        empty.sample( ds.data(), ds.size(), 1, args... );
+        std::nth_element( ds.begin(), ds.begin() + ds.size() / 2, ds.end() );
+        return ds[ ds.size() / 2 ];
+    }
+
+    // n samples of `batchSize` invocations each, with setup/teardown (if any) run between the
+    // samples while the clock is stopped
+    void sampleInto( Duration* ds, size_t n, size_t batchSize, Ts&... args ) const
+    {
+        if ( !setup.has_value() && !teardown.has_value() )
+        {
+            subject->sample( ds, n, batchSize, args... );
+            return;
+        }
+        for ( size_t i = 0; i < n; ++i )
+        {
+            if ( setup.has_value() )
+            {
+                setup.value()( batchSize, args... );
+            }
+            subject->sample( ds + i, 1, batchSize, args... );
+            if ( teardown.has_value() )
+            {
+                teardown.value()( args... );
+            }
+        }
+    }
+
+    // like sampleInto(), with the event and allocation counters (either may be null) running
+    // only while the task is
+    void sampleCounted( const Perf::CounterGroup* group,
+                        Allocations::Counter* allocations,
+                        Duration* ds,
+                        size_t n,
+                        size_t batchSize,
+                        Ts&... args ) const
+    {
+        auto counted = [ & ]( Duration* first, size_t count ) {
+            if ( group )
+            {
+                group->start();
+            }
+            if ( allocations )
+            {
+                allocations->start();
+            }
+            subject->sample( first, count, batchSize, args... );
+            if ( allocations )
+            {
+                allocations->stop();
+            }
+            if ( group )
+            {
+                group->stop();
+            }
+        };
+        if ( !setup.has_value() && !teardown.has_value() )
+        {
+            counted( ds, n );
+            return;
+        }
+        for ( size_t i = 0; i < n; ++i )
+        {
+            if ( setup.has_value() )
+            {
+                setup.value()( batchSize, args... );
+            }
+            counted( ds + i, 1 );
+            if ( teardown.has_value() )
+            {
+                teardown.value()( args... );
+            }
+        }
+    }
+
+    [[nodiscard]] size_t threadCount( const Ts&... args ) const
+    {
+        if ( !threadsArgument.has_value() )
+        {
+            return threads;
+        }
+        auto n = threads;
+        size_t i{ 0 };
+        [[maybe_unused]] auto pick = [ & ]( const auto& arg ) {
+            if constexpr ( std::is_integral_v< std::decay_t< decltype( arg ) > > )
+            {
+                if ( i == threadsArgument.value() )
+                {
+                    n = static_cast< size_t >( arg );
+                }
+            }
+            ++i;
+        };
+        ( pick( args ), ... );
+        return std::max< size_t >( n, 1 );
+    }
+
+    // the pooled samples of n threads; fills in the record's contention
+    std::vector< Duration > sampleContended( RecordMultiDim<>& r, size_t n, Ts&... args ) const
+    {
+        auto perThread = std::max< size_t >( multiplier, 1 );
+        std::vector< Duration > ds( n * perThread );
+        auto wall = sampleConcurrently( ds.data(), n, perThread, r.batch, args... );
+        auto throughput = [ & ]( size_t threadsUsed, Duration elapsed ) {
+            auto seconds = std::chrono::duration< double >( elapsed ).count();
+            auto ops = static_cast< double >( threadsUsed * perThread * r.batch );
+            return seconds > 0 ? ops / seconds : 0.0;
+        };
+        r.contention.threads = n;
+        r.contention.opsPerSecond = throughput( n, wall );
+        auto single = r.contention.opsPerSecond;
+        if ( n > 1 )
+        {
+            std::vector< Duration > baseline( perThread );
+            auto elapsed = sampleConcurrently( baseline.data(), 1, perThread, r.batch, args... );
+            single = throughput( 1, elapsed );
+        }
+        r.contention.efficiency =
+            single > 0 ? r.contention.opsPerSecond / ( static_cast< double >( n ) * single ) : 0.0;
+        auto perInvocation = static_cast< long >( perThread * r.batch );
+        for ( size_t t = 0; t < n; ++t )
+        {
+            auto first = ds.cbegin() + static_cast< long >( t * perThread );
+            r.contention.perThread.push_back(
+                std::accumulate( first, first + static_cast< long >( perThread ), Duration{} )
+                / perInvocation );
+        }
+        return ds;
+    }
+
+    // n threads (the calling one included) each take `perThread` samples into their own slice
+    // of ds once all of them are ready; returns the time from the first start to the last stop
+    Duration sampleConcurrently(
+        Duration* ds, size_t n, size_t perThread, size_t batchSize, Ts&... args ) const
+    {
+        using std::chrono::steady_clock;
+        SpinBarrier barrier( n );
+        std::vector< steady_clock::time_point > begins( n );
+        std::vector< steady_clock::time_point > ends( n );
+        auto work = [ & ]( size_t t ) {
+            barrier.arriveAndWait();
+            begins[ t ] = steady_clock::now();
+            sampleInto( ds + t * perThread, perThread, batchSize, args... );
+            ends[ t ] = steady_clock::now();
+        };
+        std::vector< std::thread > workers;
+        for ( size_t t = 1; t < n; ++t )
+        {
+            workers.emplace_back( work, t );
+        }
+        work( 0 );
+        for ( auto& worker : workers )
+        {
+            worker.join();
+        }
+        return std::chrono::duration_cast< Duration >(
+            *std::max_element( ends.cbegin(), ends.cend() )
+            - *std::min_element( begins.cbegin(), begins.cend() ) );
+    }
+
+    size_t warmUp( size_t batchSize, Ts&... args ) const
+    {
+        std::vector< Duration > ds( warmup );
+        sampleInto( ds.data(), ds.size(), batchSize, args... );
+        return warmup;
+    }
+
+    size_t warmUpUntilStable( size_t batchSize, Ts&... args ) const
+    {
+        std::vector< Duration > window( warmupWindow );
+        auto median = [ &window ]() {
+            std::nth_element( window.begin(), window.begin() + window.size() / 2, window.end() );
+            return static_cast< double >( window[ window.size() / 2 ].count() );
+        };
+        sampleInto( window.data(), window.size(), batchSize, args... );
+        auto previous = median();
+        size_t runs{ warmupWindow };
+        while ( runs < warmup )
+        {
+            sampleInto( window.data(), window.size(), batchSize, args... );
+            runs += warmupWindow;
+            auto current = median();
+            if ( std::abs( current - previous ) <= warmupTolerance * std::max( previous, 1.0 ) )
+            {
+                break;
+            }
+            previous = current;
+        }
+        return runs;
+    }
+
+    // append samples in rounds growing by half of what is there, stopping when the relative
+    // width of the mean's confidence interval drops below the target, the budget is spent or
+    // maxAdaptiveRuns is reached; returns whether the target precision (if any) was met
+    bool sampleAdaptively( std::vector< Duration >& ds,
+                           size_t batchSize,
+                           std::chrono::steady_clock::time_point started,
+                           Ts&... args ) const
+    {
+        while ( true )
+        {
+            if ( targetPrecision.has_value() && ds.size() >= minAdaptiveRuns
+                 && Stats::relativeIntervalWidth( ds ) <= targetPrecision.value() )
+            {
+                return true;
+            }
+            auto spent = std::chrono::steady_clock::now() - started;
+            if ( ( timeBudget.has_value() && spent >= timeBudget.value() )
+                 || ds.size() >= maxAdaptiveRuns )
+            {
+                return !targetPrecision.has_value();
+            }
+            auto n = ds.size();
+            auto round = std::min( std::max< size_t >( n / 2, 1 ), maxAdaptiveRuns - n );
+            if ( timeBudget.has_value() )
+            {
+                // don't overshoot the budget by much on slow tasks
+                using std::chrono::duration_cast;
+                auto perSample = std::max< long >(
+                    duration_cast< Duration >( spent ).count() / static_cast< long >( n ), 1 );
+                auto left = duration_cast< Duration >( timeBudget.value() - spent ).count();
+                round = std::clamp< size_t >( left / perSample, 1, round );
+            }
+            ds.resize( n + round );
+            sampleInto( ds.data() + n, round, batchSize, args... );
+        }
+    }
+
+    // grow the batch geometrically from 1 until a single batch spans the target, or up to
+    // maxBatch invocations for a task too cheap to get there
+    [[nodiscard]] size_t chooseBatch( Duration target, Ts&... args ) const
+    {
+        size_t k{ 1 };
+        Duration d{};
+        while ( k < maxBatch )
+        {
+            sampleInto( &d, 1, k, args... );
+            if ( d >= target )
+            {
+                break;
+            }
+            auto kl = static_cast< long >( k );
+            auto estimate = d.count() > 0 ? target.count() * kl / d.count() + 1 : kl * 10;
+            k = std::clamp< size_t >( estimate, k * 2, k * 10 );
+        }
+        return std::min( k, maxBatch );
+    }
+
+    // a sample whose median is within this many multiples of the overhead is flagged
+    static constexpr long noiseFloorFactor = 3;
+    static constexpr size_t calibrationRuns = 1000;
+    // a million invocations keep even a nanosecond task well above the clock's resolution
+    static constexpr size_t maxBatch = size_t{ 1 } << 20;
+    // the normal approximation behind the precision target is not trusted on fewer runs
+    static constexpr size_t minAdaptiveRuns = 10;
+    static constexpr size_t maxAdaptiveRuns = 10000000;
+    static constexpr size_t warmupWindow = 10;
+    static constexpr double warmupTolerance = 0.05;
+
+private:
+    struct EmptyTask
+    {
+        void operator()( const Ts&... ) const
+        {
+        }
+    };
 };
+
+template < typename... Ts >
+using Measurable = BasicMeasurable< DefaultClock, Ts... >;
 }  // namespace Impl
 
 }  // namespace AutoTimer
@@ -0,0 +1,78 @@
+//
+// Created by weining on 18/10/26.
+//
+
+#ifndef AUTOTIMER_OPTIMIZER_HH
+#define AUTOTIMER_OPTIMIZER_HH
+
+#include <atomic>
+#include <type_traits>
+
+namespace AutoTimer
+{
+#if defined( __GNUC__ ) || defined( __clang__ )
+
+// make the compiler assume the value is read by someone it cannot see, so the work producing
+// it is not eliminated; small trivially copyable values may stay in a register
+template < typename T >
+inline void doNotOptimize( const T& value )
+{
+    if constexpr ( std::is_trivially_copyable_v< T > && sizeof( T ) <= sizeof( void* ) )
+    {
+        asm volatile( "" : : "r,m"( value ) : "memory" );
+    }
+    else
+    {
+        asm volatile( "" : : "m"( value ) : "memory" );
+    }
+}
+
+// as above, and also assume the value may have been modified
+template < typename T >
+inline void doNotOptimize( T& value )
+{
+    if constexpr ( std::is_trivially_copyable_v< T > && sizeof( T ) <= sizeof( void* ) )
+    {
+#if defined( __clang__ )
+        asm volatile( "" : "+r,m"( value ) : : "memory" );
+#else
+        asm volatile( "" : "+m,r"( value ) : : "memory" );
+#endif
+    }
+    else
+    {
+        asm volatile( "" : "+m"( value ) : : "memory" );
+    }
+}
+
+// make the compiler assume all memory may have been read and written, so pending stores are
+// flushed and nothing is cached across the call
+inline void clobberMemory()
+{
+    asm volatile( "" : : : "memory" );
+}
+
+#else
+
+namespace Impl
+{
+inline const volatile void* volatile sink{ nullptr };
+}
+
+template < typename T >
+inline void doNotOptimize( const T& value )
+{
+    Impl::sink = &value;
+    std::atomic_signal_fence( std::memory_order_seq_cst );
+}
+
+inline void clobberMemory()
+{
+    std::atomic_signal_fence( std::memory_order_seq_cst );
+}
+
+#endif
+
+}  // namespace AutoTimer
+
+#endif  // AUTOTIMER_OPTIMIZER_HH
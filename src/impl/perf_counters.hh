@@ -0,0 +1,201 @@
+//
+// Created by weining on 18/10/26.
+//
+
+#ifndef AUTOTIMER_PERF_COUNTERS_HH
+#define AUTOTIMER_PERF_COUNTERS_HH
+
+#include "time_record.hh"
+
+#include <array>
+#include <cstdint>
+#include <utility>
+
+#if defined( __linux__ )
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#define AUTOTIMER_HAS_PERF_EVENTS 1
+#else
+#define AUTOTIMER_HAS_PERF_EVENTS 0
+#endif
+
+namespace AutoTimer::Perf
+{
+using TimeRecord::Counters;
+
+// the calling thread's event counters, opened through perf_event_open(2): cycles, instructions,
+// branch misses and the software counters form one group (so the IPC is taken over the same
+// window), the cache and TLB misses a second one that is scaled if the kernel multiplexes it;
+// the software counters still work in containers where the hardware ones are unavailable. Each
+// group is switched on and off by one ioctl on its leader. Events the kernel refuses (e.g. under
+// perf_event_paranoid, or on virtual machines without a PMU) are left out, and an event that
+// can not join its group is opened on its own
+class CounterGroup
+{
+public:
+    CounterGroup()
+    {
+        fds.fill( -1 );
+#if AUTOTIMER_HAS_PERF_EVENTS
+        std::array< int, 2 > groupLeaders{ -1, -1 };
+        for ( size_t e = 0; e < Counters::EventCount; ++e )
+        {
+            auto event = static_cast< Counters::Event >( e );
+            auto [ type, config ] = eventConfig( event );
+            auto& leader = groupLeaders[ groupOf( event ) ];
+            fds[ e ] = open( type, config, leader );
+            if ( fds[ e ] < 0 && leader >= 0 )
+            {
+                fds[ e ] = open( type, config, -1 );
+                leads[ e ] = fds[ e ] >= 0;
+            }
+            else if ( leader < 0 && fds[ e ] >= 0 )
+            {
+                leader = fds[ e ];
+                leads[ e ] = true;
+            }
+        }
+#endif
+    }
+
+    CounterGroup( const CounterGroup& ) = delete;
+    CounterGroup& operator=( const CounterGroup& ) = delete;
+
+    ~CounterGroup()
+    {
+#if AUTOTIMER_HAS_PERF_EVENTS
+        for ( auto fd : fds )
+        {
+            if ( fd >= 0 )
+            {
+                close( fd );
+            }
+        }
+#endif
+    }
+
+    [[nodiscard]] bool empty() const
+    {
+        for ( auto fd : fds )
+        {
+            if ( fd >= 0 )
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // counting accumulates over every start()/stop() pair
+    void start() const
+    {
+        control( true );
+    }
+
+    void stop() const
+    {
+        control( false );
+    }
+
+    // the counts so far divided by the number of invocations they cover
+    [[nodiscard]] Counters read( double invocations ) const
+    {
+        Counters c{};
+#if AUTOTIMER_HAS_PERF_EVENTS
+        for ( size_t e = 0; e < Counters::EventCount; ++e )
+        {
+            // value, time enabled, time running
+            std::uint64_t values[ 3 ]{};
+            if ( fds[ e ] < 0 || ::read( fds[ e ], values, sizeof( values ) ) != sizeof( values )
+                 || values[ 2 ] == 0 )
+            {
+                continue;
+            }
+            auto enabled = static_cast< double >( values[ 1 ] );
+            auto running = static_cast< double >( values[ 2 ] );
+            auto scaled = static_cast< double >( values[ 0 ] ) * enabled / running;
+            c.available[ e ] = true;
+            c.perOp[ e ] = invocations > 0 ? scaled / invocations : scaled;
+        }
+#endif
+        return c;
+    }
+
+private:
+#if AUTOTIMER_HAS_PERF_EVENTS
+    static size_t groupOf( Counters::Event e )
+    {
+        return e == Counters::L1dMisses || e == Counters::LlcMisses || e == Counters::DtlbMisses;
+    }
+
+    static std::pair< std::uint32_t, std::uint64_t > eventConfig( Counters::Event e )
+    {
+        auto cache = []( std::uint64_t id ) {
+            return id | ( PERF_COUNT_HW_CACHE_OP_READ << 8 )
+                   | ( PERF_COUNT_HW_CACHE_RESULT_MISS << 16 );
+        };
+        switch ( e )
+        {
+        case Counters::Cycles:
+            return { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES };
+        case Counters::Instructions:
+            return { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS };
+        case Counters::BranchMisses:
+            return { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES };
+        case Counters::L1dMisses:
+            return { PERF_TYPE_HW_CACHE, cache( PERF_COUNT_HW_CACHE_L1D ) };
+        case Counters::LlcMisses:
+            return { PERF_TYPE_HW_CACHE, cache( PERF_COUNT_HW_CACHE_LL ) };
+        case Counters::DtlbMisses:
+            return { PERF_TYPE_HW_CACHE, cache( PERF_COUNT_HW_CACHE_DTLB ) };
+        case Counters::TaskClock:
+            return { PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK };
+        case Counters::PageFaults:
+            return { PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS };
+        default:
+            return { PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES };
+        }
+    }
+
+    // user space only, which perf_event_paranoid up to 2 still allows for the own thread
+    static int open( std::uint32_t type, std::uint64_t config, int groupFd )
+    {
+        perf_event_attr attr{};
+        attr.size = sizeof( attr );
+        attr.type = type;
+        attr.config = config;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        return static_cast< int >( syscall( __NR_perf_event_open, &attr, 0, -1, groupFd, 0 ) );
+    }
+#endif
+
+    void control( bool enable ) const
+    {
+#if AUTOTIMER_HAS_PERF_EVENTS
+        for ( size_t e = 0; e < Counters::EventCount; ++e )
+        {
+            if ( leads[ e ] )
+            {
+                ioctl( fds[ e ],
+                       enable ? PERF_EVENT_IOC_ENABLE : PERF_EVENT_IOC_DISABLE,
+                       PERF_IOC_FLAG_GROUP );
+            }
+        }
+#else
+        ( void )enable;
+#endif
+    }
+
+    std::array< int, Counters::EventCount > fds{};
+    // the group leaders and the events opened on their own, each controlled by one ioctl
+    std::array< bool, Counters::EventCount > leads{};
+};
+
+}  // namespace AutoTimer::Perf
+
+#endif  // AUTOTIMER_PERF_COUNTERS_HH
@@ -0,0 +1,476 @@
+//
+// Created by weining on 18/10/26.
+//
+
+#ifndef AUTOTIMER_RESULT_STORE_HH
+#define AUTOTIMER_RESULT_STORE_HH
+
+#include "export.hh"
+#include "time_record.hh"
+
+#include <array>
+#include <cstdint>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace AutoTimer
+{
+using namespace TimeRecord;
+
+// every distinct string once; rows refer to them by index
+class StringPool
+{
+public:
+    std::uint32_t intern( const std::string& s )
+    {
+        auto found = ids.find( s );
+        if ( found != ids.end() )
+        {
+            return found->second;
+        }
+        auto id = static_cast< std::uint32_t >( strings.size() );
+        strings.push_back( s );
+        ids.emplace( s, id );
+        return id;
+    }
+
+    [[nodiscard]] const std::string& str( std::uint32_t id ) const
+    {
+        return strings[ id ];
+    }
+
+    [[nodiscard]] size_t size() const
+    {
+        return strings.size();
+    }
+
+private:
+    std::vector< std::string > strings;
+    std::unordered_map< std::string, std::uint32_t > ids;
+};
+
+// a contiguous run of a ragged column
+template < typename T >
+struct Slice
+{
+    const T* first{ nullptr };
+    const T* last{ nullptr };
+
+    [[nodiscard]] const T* begin() const
+    {
+        return first;
+    }
+
+    [[nodiscard]] const T* end() const
+    {
+        return last;
+    }
+
+    [[nodiscard]] size_t size() const
+    {
+        return static_cast< size_t >( last - first );
+    }
+
+    [[nodiscard]] bool empty() const
+    {
+        return first == last;
+    }
+};
+
+// the results of a report as flat columns with one row per measured point: a column per scaling
+// parameter, the statistics side by side, and the raw samples of all rows in one array. Unlike
+// the record tree (see Report) it takes a handful of allocations however large the sweep, and a
+// statistic across the sweep is a single contiguous scan. Rows are appended record by record in
+// the order scale() visits the grid
+template < typename... Ts >
+struct ResultStore
+{
+    static constexpr size_t dimensionCount = sizeof...( Ts );
+    using Point = std::tuple< Ts... >;
+
+    std::string label{};
+    StringPool strings{};
+    // the interned labels of the scaling parameters, outermost first
+    std::array< std::uint32_t, sizeof...( Ts ) > dimensions{};
+
+    std::tuple< std::vector< Ts >... > coordinates{};
+    // the outermost dimension in which the row's point differs from the previous row's (0 on the
+    // first row of a record), which groups the rows without comparing parameter values
+    std::vector< std::uint8_t > divergence{};
+
+    // the measure's position in the report and its interned label
+    std::vector< std::uint32_t > record{};
+    std::vector< std::uint32_t > measure{};
+
+    std::vector< size_t > runs{};
+    std::vector< Duration > mean{};
+    std::vector< Duration > fastest{};
+    std::vector< Duration > slowest{};
+    std::vector< Statistics > statistics{};
+
+    std::vector< Duration > overhead{};
+    std::vector< bool > nearNoiseFloor{};
+    std::vector< size_t > batch{};
+    std::vector< Duration > batchMin{};
+    std::vector< Duration > batchMax{};
+    std::vector< size_t > warmupRuns{};
+    std::vector< Outliers > outliers{};
+    std::vector< Counters > counters{};
+    std::vector< AllocationCounts > allocations{};
+    std::vector< int > cpu{};
+    std::vector< bool > converged{};
+
+    std::vector< size_t > threads{};
+    std::vector< double > opsPerSecond{};
+    std::vector< double > efficiency{};
+
+    // ragged columns: row i owns [offsets[i], offsets[i + 1])
+    std::vector< size_t > perThreadOffsets{ 0 };
+    std::vector< Duration > perThread{};
+    std::vector< size_t > sampleOffsets{ 0 };
+    std::vector< Duration > samples{};
+    // the non-empty histogram buckets as (index, count), with the precision and range of each
+    // row's histogram; a row takes as many entries as it has distinct values at that precision
+    std::vector< std::uint8_t > histogramDigits{};
+    std::vector< Duration > histogramHighest{};
+    std::vector< size_t > histogramOffsets{ 0 };
+    std::vector< std::uint32_t > histogramBuckets{};
+    std::vector< std::uint64_t > histogramCounts{};
+
+    [[nodiscard]] size_t size() const
+    {
+        return record.size();
+    }
+
+    [[nodiscard]] bool empty() const
+    {
+        return record.empty();
+    }
+
+    void withDimensionLabels( const std::array< std::string, sizeof...( Ts ) >& labels )
+    {
+        for ( size_t d = 0; d < dimensionCount; ++d )
+        {
+            dimensions[ d ] = strings.intern( labels[ d ] );
+        }
+    }
+
+    [[nodiscard]] const std::string& dimensionLabel( size_t d ) const
+    {
+        return strings.str( dimensions[ d ] );
+    }
+
+    void append( std::uint32_t recordIndex,
+                 const Point& point,
+                 size_t diverging,
+                 const RecordMultiDim<>& r )
+    {
+        appendPoint( point, std::index_sequence_for< Ts... >{} );
+        divergence.push_back( static_cast< std::uint8_t >( diverging ) );
+        record.push_back( recordIndex );
+        measure.push_back( strings.intern( r.label() ) );
+        runs.push_back( std::get< 1 >( r.summary ) );
+        mean.push_back( std::get< 2 >( r.summary ) );
+        fastest.push_back( std::get< 3 >( r.summary ) );
+        slowest.push_back( std::get< 4 >( r.summary ) );
+        statistics.push_back( r.statistics );
+        overhead.push_back( r.overhead );
+        nearNoiseFloor.push_back( r.nearNoiseFloor );
+        batch.push_back( r.batch );
+        batchMin.push_back( r.batchMin );
+        batchMax.push_back( r.batchMax );
+        warmupRuns.push_back( r.warmupRuns );
+        outliers.push_back( r.outliers );
+        counters.push_back( r.counters );
+        allocations.push_back( r.allocations );
+        cpu.push_back( r.cpu );
+        converged.push_back( r.converged );
+        threads.push_back( r.contention.threads );
+        opsPerSecond.push_back( r.contention.opsPerSecond );
+        efficiency.push_back( r.contention.efficiency );
+        perThread.insert(
+            perThread.end(), r.contention.perThread.cbegin(), r.contention.perThread.cend() );
+        perThreadOffsets.push_back( perThread.size() );
+        samples.insert( samples.end(), r.samples.cbegin(), r.samples.cend() );
+        sampleOffsets.push_back( samples.size() );
+        histogramDigits.push_back( static_cast< std::uint8_t >( r.histogram.significantDigits() ) );
+        histogramHighest.push_back( r.histogram.highest() );
+        r.histogram.forEachCount( [ this ]( size_t index, std::uint64_t count ) {
+            histogramBuckets.push_back( static_cast< std::uint32_t >( index ) );
+            histogramCounts.push_back( count );
+        } );
+        histogramOffsets.push_back( histogramCounts.size() );
+    }
+
+    [[nodiscard]] Slice< Duration > samplesOf( size_t row ) const
+    {
+        return { samples.data() + sampleOffsets[ row ], samples.data() + sampleOffsets[ row + 1 ] };
+    }
+
+    [[nodiscard]] Slice< Duration > perThreadOf( size_t row ) const
+    {
+        return { perThread.data() + perThreadOffsets[ row ],
+                 perThread.data() + perThreadOffsets[ row + 1 ] };
+    }
+
+    [[nodiscard]] Hdr::Histogram histogramOf( size_t row ) const
+    {
+        Hdr::Histogram h( histogramDigits[ row ], histogramHighest[ row ] );
+        auto first = histogramOffsets[ row ];
+        h.restore( histogramBuckets.data() + first,
+                   histogramCounts.data() + first,
+                   histogramOffsets[ row + 1 ] - first );
+        return h;
+    }
+
+    [[nodiscard]] const std::string& measureLabel( size_t row ) const
+    {
+        return strings.str( measure[ row ] );
+    }
+
+    [[nodiscard]] Point pointOf( size_t row ) const
+    {
+        return std::apply(
+            [ row ]( const auto&... columns ) { return Point{ columns[ row ]... }; },
+            coordinates );
+    }
+
+    // the row as a record, for the renderers and exporters working on one record at a time
+    [[nodiscard]] RecordMultiDim<> leaf( size_t row ) const
+    {
+        RecordMultiDim<> r{ std::make_tuple(
+            measureLabel( row ), runs[ row ], mean[ row ], fastest[ row ], slowest[ row ] ) };
+        r.statistics = statistics[ row ];
+        r.overhead = overhead[ row ];
+        r.nearNoiseFloor = nearNoiseFloor[ row ];
+        r.batch = batch[ row ];
+        r.batchMin = batchMin[ row ];
+        r.batchMax = batchMax[ row ];
+        r.warmupRuns = warmupRuns[ row ];
+        r.outliers = outliers[ row ];
+        r.counters = counters[ row ];
+        r.allocations = allocations[ row ];
+        r.cpu = cpu[ row ];
+        r.converged = converged[ row ];
+        r.contention.threads = threads[ row ];
+        r.contention.opsPerSecond = opsPerSecond[ row ];
+        r.contention.efficiency = efficiency[ row ];
+        auto ts = perThreadOf( row );
+        r.contention.perThread.assign( ts.begin(), ts.end() );
+        auto ds = samplesOf( row );
+        r.samples.assign( ds.begin(), ds.end() );
+        r.histogram = histogramOf( row );
+        return r;
+    }
+
+    // the coordinates of the row in dimensions [0, last), as the exporters see them
+    [[nodiscard]] Coordinates coordinatesOf( size_t row, size_t last = sizeof...( Ts ) ) const
+    {
+        Coordinates cs;
+        forEachCoordinate( row, [ & ]( size_t d, const auto& value ) {
+            if ( d < last )
+            {
+                cs.push_back( makeCoordinate( dimensionLabel( d ), value ) );
+            }
+        } );
+        return cs;
+    }
+
+    // call visit( d, value ) for the row's value in every dimension, outermost first
+    template < typename Visitor >
+    void forEachCoordinate( size_t row, Visitor&& visit ) const
+    {
+        forEachCoordinate( row, visit, std::index_sequence_for< Ts... >{} );
+    }
+
+    // the same text as render() gives for the record tree: a header line per outer coordinate
+    // and a line per innermost one, the rows of a group followed by an empty line
+    std::ostream& formatted( std::ostream& os, AutoTimer::TimeUnitOptions opt ) const
+    {
+        os << label << '\n';
+        constexpr size_t innermost = dimensionCount ? dimensionCount - 1 : 0;
+        for ( size_t row = 0; row < size(); ++row )
+        {
+            auto r = leaf( row );
+            if constexpr ( dimensionCount == 0 )
+            {
+                render( os, 4, opt, r );
+            }
+            else
+            {
+                size_t from = divergence[ row ];
+                for ( auto d = innermost; row > 0 && d-- > from; )
+                {
+                    os << '\n';
+                }
+                forEachCoordinate( row, [ & ]( size_t d, const auto& value ) {
+                    if ( d < from )
+                    {
+                        return;
+                    }
+                    os << std::string( 4 + 4 * d, ' ' ) << dimensionLabel( d ) << '(' << value
+                       << ( d < innermost ? ")\n" : ") " );
+                } );
+                renderCastedSummary( os, 0, opt, r.castSummary( opt ) );
+                renderRecordDetails( os, 4 + 4 * innermost, opt, r );
+            }
+        }
+        for ( size_t d = 0; !empty() && d < innermost; ++d )
+        {
+            os << '\n';
+        }
+        return os;
+    }
+
+    // {"label": ..., "records": [...]} with one object per row
+    std::ostream& json( std::ostream& os ) const
+    {
+        os << "{\"label\": ";
+        writeJsonString( os, label ) << ", \"records\": [";
+        for ( size_t row = 0; row < size(); ++row )
+        {
+            writeJsonRecord( os << ( row ? ",\n  " : "\n  " ), coordinatesOf( row ), leaf( row ) );
+        }
+        return os << "\n]}\n";
+    }
+
+    // a header line naming the scaling parameters, then one line per row
+    std::ostream& csv( std::ostream& os ) const
+    {
+        if ( empty() )
+        {
+            return os;
+        }
+        os << "measure,";
+        for ( size_t d = 0; d < dimensionCount; ++d )
+        {
+            writeCsvField( os, dimensionLabel( d ) ) << ',';
+        }
+        os << csvColumns() << '\n';
+        for ( size_t row = 0; row < size(); ++row )
+        {
+            writeCsvRecord( os, coordinatesOf( row ), leaf( row ) );
+        }
+        return os;
+    }
+
+    std::ostream& write( std::ostream& os,
+                         OutputFormat format,
+                         AutoTimer::TimeUnitOptions opt ) const
+    {
+        if ( format == OutputFormat::Json )
+        {
+            return json( os );
+        }
+        else if ( format == OutputFormat::Csv )
+        {
+            return csv( os );
+        }
+        return formatted( os, opt );
+    }
+
+private:
+    template < size_t... Is >
+    void appendPoint( const Point& point, std::index_sequence< Is... > )
+    {
+        ( std::get< Is >( coordinates ).push_back( std::get< Is >( point ) ), ... );
+    }
+
+    template < typename Visitor, size_t... Is >
+    void forEachCoordinate( [[maybe_unused]] size_t row,
+                            Visitor& visit,
+                            std::index_sequence< Is... > ) const
+    {
+        ( visit( Is, std::get< Is >( coordinates )[ row ] ), ... );
+    }
+};
+
+// append the leaves of a record tree to the store in depth-first order; `diverging` carries the
+// outermost dimension whose value changed since the previous leaf
+template < size_t D, typename Point, typename... Ts >
+void appendLeaves( ResultStore< Ts... >& store,
+                   std::uint32_t recordIndex,
+                   const RecordMultiDim<>& leaf,
+                   Point& point,
+                   size_t& diverging )
+{
+    store.append( recordIndex, point, diverging, leaf );
+    diverging = D;
+}
+
+template < size_t D, typename Point, typename... Ts, typename T, typename... Us >
+void appendLeaves( ResultStore< Ts... >& store,
+                   std::uint32_t recordIndex,
+                   const RecordMultiDim< T, Us... >& record,
+                   Point& point,
+                   size_t& diverging )
+{
+    if ( !record.fields.empty() )
+    {
+        store.dimensions[ D ] = store.strings.intern( record.label );
+    }
+    for ( const auto& [ parameter, field ] : record.fields )
+    {
+        diverging = std::min( diverging, D );
+        std::get< D >( point ) = parameter;
+        appendLeaves< D + 1 >( store, recordIndex, field, point, diverging );
+    }
+}
+
+// the measures of a report as record trees, one per measure() call; the Builder keeps its
+// results in a ResultStore, which results() converts to
+template < typename... Ts >
+struct Report
+{
+    std::string label{};
+    std::vector< RecordMultiDim< Ts... > > timeRecords{};
+
+    [[nodiscard]] ResultStore< Ts... > results() const
+    {
+        ResultStore< Ts... > store{};
+        store.label = label;
+        typename ResultStore< Ts... >::Point point{};
+        for ( size_t i = 0; i < timeRecords.size(); ++i )
+        {
+            size_t diverging{ 0 };
+            appendLeaves< 0 >(
+                store, static_cast< std::uint32_t >( i ), timeRecords[ i ], point, diverging );
+        }
+        return store;
+    }
+
+    // the third argument of the original signature was never used
+    std::ostream& formatted( std::ostream& os,
+                             AutoTimer::TimeUnitOptions opt,
+                             const std::string& = {} ) const
+    {
+        return results().formatted( os, opt );
+    }
+
+    std::ostream& json( std::ostream& os ) const
+    {
+        return results().json( os );
+    }
+
+    std::ostream& csv( std::ostream& os ) const
+    {
+        return results().csv( os );
+    }
+
+    std::ostream& write( std::ostream& os,
+                         OutputFormat format,
+                         AutoTimer::TimeUnitOptions opt ) const
+    {
+        return results().write( os, format, opt );
+    }
+};
+
+}  // namespace AutoTimer
+
+#endif  // AUTOTIMER_RESULT_STORE_HH
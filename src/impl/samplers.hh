@@ -0,0 +1,84 @@
+//
+// Created by weining on 18/10/26.
+//
+
+#ifndef AUTOTIMER_SAMPLERS_HH
+#define AUTOTIMER_SAMPLERS_HH
+
+#include <chrono>
+#include <cstdint>
+
+// the policies deciding which scopes a SamplingTimer times; take() runs on every scope entry,
+// so each keeps its state in a thread-local and touches nothing shared
+
+namespace AutoTimer::Samplers
+{
+// every scope
+struct Always
+{
+    static bool take() noexcept
+    {
+        return true;
+    }
+};
+
+// every n-th scope of the thread
+template < std::uint32_t N >
+struct OneIn
+{
+    static_assert( N > 0, "sample at least one in N" );
+
+    static bool take() noexcept
+    {
+        thread_local std::uint32_t countdown{ N };
+        if ( --countdown )
+        {
+            return false;
+        }
+        countdown = N;
+        return true;
+    }
+};
+
+// each scope independently with the probability PerMillion / 1,000,000, drawn from a per-thread
+// xorshift generator
+template < std::uint32_t PerMillion >
+struct Probability
+{
+    static_assert( PerMillion <= 1000000, "a probability is at most one million per million" );
+
+    static bool take() noexcept
+    {
+        thread_local std::uint64_t state{ 0x9e3779b97f4a7c15ull
+                                          ^ reinterpret_cast< std::uintptr_t >( &state ) };
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return ( ( state >> 32 ) * 1000000 >> 32 ) < PerMillion;
+    }
+};
+
+// at most PerSecond scopes per second of the thread, evenly spaced; reads the steady clock on
+// every scope entry, but never stops it for the skipped ones
+template < std::uint32_t PerSecond >
+struct RateLimited
+{
+    static_assert( PerSecond > 0, "sample at least once per second" );
+
+    static bool take() noexcept
+    {
+        using namespace std::chrono;
+        thread_local steady_clock::time_point next{};
+        auto now = steady_clock::now();
+        if ( now < next )
+        {
+            return false;
+        }
+        next = now + duration_cast< steady_clock::duration >( seconds( 1 ) ) / PerSecond;
+        return true;
+    }
+};
+
+}  // namespace AutoTimer::Samplers
+
+#endif  // AUTOTIMER_SAMPLERS_HH
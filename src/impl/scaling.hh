@@ -5,13 +5,25 @@
 #ifndef AUTOTIMER_SCALING_HH
 #define AUTOTIMER_SCALING_HH
 
+#include "affinity.hh"
 #include "measurable.hh"
+#include "result_store.hh"
 #include "time_record.hh"
 #include "utilities.hh"
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
 #include <iostream>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <thread>
 #include <tuple>
 #include <chrono>
+#include <utility>
 #include <vector>
 #include <type_traits>
 #include <memory>
@@ -29,6 +41,7 @@ struct ScalingParam
     virtual T begin() = 0;
     virtual bool end( T ) = 0;
     virtual T next( T ) = 0;
+    virtual ~ScalingParam() = default;
 };
 
 template < typename T >
@@ -109,10 +122,134 @@ struct Discrete : public ScalingParam< T >
         return it >= std::size( values );
     }
 
-    T next( T ) override
+    T next( T curr ) override
     {
         ++it;
-        return values[ it ];
+        return it < std::size( values ) ? values[ it ] : curr;
+    }
+};
+
+// The generators below are plain value types (no virtual calls, no allocation of their own):
+// anything with `T begin() const`, `bool end( T ) const` and `T next( T ) const` keeping its
+// position in the value it hands out can be used as a scaling parameter through
+// makeParameter().
+
+// start, start * factor, start * factor^2, ... up to and including end, e.g. the powers of two
+// from 1K to 16M; the growth is computed in double and checked against the end before it is
+// converted back, so an end close to the largest T does not overflow (the end itself must be
+// below the largest integral T, see makeGeometric())
+template < typename T >
+struct Geometric
+{
+    T startV;
+    T endV;
+    double factor{ 2.0 };
+
+    T begin() const
+    {
+        return startV;
+    }
+
+    bool end( T curr ) const
+    {
+        return curr > endV;
+    }
+
+    T next( T curr ) const
+    {
+        auto grown = static_cast< double >( curr ) * factor;
+        if ( curr >= endV || grown > static_cast< double >( endV ) )
+        {
+            return pastEnd();
+        }
+        // indistinguishable from the end in double (only for ends beyond 2^53): clamped to it
+        if ( grown == static_cast< double >( endV ) )
+        {
+            return endV;
+        }
+        auto value = static_cast< T >( grown );
+        // integral values must move on even when the factor is too small to change them
+        return value > curr ? value : curr + 1;
+    }
+
+    T pastEnd() const
+    {
+        if constexpr ( std::is_integral_v< T > )
+        {
+            return endV + 1;
+        }
+        else
+        {
+            return std::numeric_limits< T >::infinity();
+        }
+    }
+};
+
+// start, start + stride, ... up to but excluding end (like Linear, which has a stride of 1); a
+// negative stride counts down. A step that would reach or pass the end stops at the end instead,
+// so an end close to the limits of T does not overflow
+template < typename T >
+struct Strided
+{
+    T startV;
+    T endV;
+    T stride;
+
+    T begin() const
+    {
+        return startV;
+    }
+
+    bool end( T curr ) const
+    {
+        return stride > 0 ? curr >= endV : curr <= endV;
+    }
+
+    T next( T curr ) const
+    {
+        auto left = stride > 0 ? distance( curr, endV ) : distance( endV, curr );
+        auto step = stride > 0 ? distance( T{}, stride ) : distance( stride, T{} );
+        return end( curr ) || left <= step ? endV : curr + stride;
+    }
+
+    // b - a for a <= b, taken in the unsigned type for integral T, which always holds it
+    static auto distance( T a, T b )
+    {
+        if constexpr ( std::is_integral_v< T > )
+        {
+            using U = std::make_unsigned_t< T >;
+            return static_cast< U >( static_cast< U >( b ) - static_cast< U >( a ) );
+        }
+        else
+        {
+            return b - a;
+        }
+    }
+};
+
+// adapts a value-type generator to the ScalingParam interface
+template < typename T, typename Generator >
+struct Generated : public ScalingParam< T >
+{
+    Generator generator;
+
+    explicit Generated( Generator g ) : generator( std::move( g ) )
+    {
+    }
+
+    T begin() override
+    {
+        return generator.begin();
+    }
+
+    bool end( T curr ) override
+    {
+        return generator.end( curr );
+    }
+
+    T next( T curr ) override
+    {
+        return generator.next( curr );
     }
 };
 
@@ -155,17 +292,64 @@ LabelledParameter< T > makeLinear( const char* s, T a, T b )
     return { s, std::make_shared< Linear< T > >( a, b ) };
 }
 
-template < typename... Ps >
-RecordMultiDim<> scale( Impl::Measurable< Ps... > me, Param< Ps... > param )
+template < typename Generator,
+           typename T = std::decay_t< decltype( std::declval< const Generator& >().begin() ) > >
+LabelledParameter< T > makeParameter( const char* s, Generator g )
+{
+    return { s, std::make_shared< Generated< T, Generator > >( std::move( g ) ) };
+}
+
+template < typename T >
+LabelledParameter< T > makeGeometric( const char* s, T a, T b, double factor = 2.0 )
+{
+    if ( factor <= 1.0 )
+    {
+        std::cerr << "makeGeometric( " << s << " ): the factor must be greater than 1\n";
+        exit( 1 );
+    }
+    if constexpr ( std::is_integral_v< T > )
+    {
+        if ( b == std::numeric_limits< T >::max() )
+        {
+            std::cerr << "makeGeometric( " << s << " ): the end must be below the largest value\n";
+            exit( 1 );
+        }
+    }
+    return makeParameter( s, Geometric< T >{ a, b, factor } );
+}
+
+template < typename T >
+LabelledParameter< T > makeGeometric( T a, T b, double factor = 2.0 )
 {
-    RecordMultiDim<> r{};
-    r.summary = std::apply( &Impl::Measurable< Ps... >::measure,
-                            std::tuple_cat( std::make_tuple( me ), param ) );
-    return r;
+    return makeGeometric( "geometric", a, b, factor );
 }
 
-template < typename T, typename... Fs, typename... Ts, typename... Ps >
-RecordMultiDim< T, Ts... > scale( Impl::Measurable< Fs... > me,
+template < typename T >
+LabelledParameter< T > makeStrided( const char* s, T a, T b, T stride )
+{
+    if ( stride == T{} )
+    {
+        std::cerr << "makeStrided( " << s << " ): the stride must not be 0\n";
+        exit( 1 );
+    }
+    return makeParameter( s, Strided< T >{ a, b, stride } );
+}
+
+template < typename T >
+LabelledParameter< T > makeStrided( T a, T b, T stride )
+{
+    return makeStrided( "strided", a, b, stride );
+}
+
+template < typename Clock, typename... Ps >
+RecordMultiDim<> scale( Impl::BasicMeasurable< Clock, Ps... > me, Param< Ps... > param )
+{
+    return std::apply( &Impl::BasicMeasurable< Clock, Ps... >::measureRecord,
+                       std::tuple_cat( std::make_tuple( me ), param ) );
+}
+
+template < typename T, typename Clock, typename... Fs, typename... Ts, typename... Ps >
+RecordMultiDim< T, Ts... > scale( Impl::BasicMeasurable< Clock, Fs... > me,
                                   Param< Ps... > param,
                                   LabelledParameter< T > labelledParameter,
                                   LabelledParameter< Ts >... parameters )
@@ -186,17 +370,412 @@ RecordMultiDim< T, Ts... > scale( Impl::Measurable< Fs... > me,
     return record;
 }
 
-template < typename... Ts >
-RecordMultiDim< Ts... > scaleWith( Impl::Measurable< Ts... > me, LabelledParameter< Ts >... args )
+template < typename Clock, typename... Ts >
+RecordMultiDim< Ts... > scaleWith( Impl::BasicMeasurable< Clock, Ts... > me,
+                                   LabelledParameter< Ts >... args )
 {
     return scale( me, Param<>{}, args... );
 }
 
-template < typename... Ts >
-RecordMultiDim< Ts... > scaleTu( Impl::Measurable< Ts... > me,
+template < typename Clock, typename... Ts >
+RecordMultiDim< Ts... > scaleTu( Impl::BasicMeasurable< Clock, Ts... > me,
                                  std::tuple< LabelledParameter< Ts >... > tu )
 {
-    return std::apply( scaleWith< Ts... >, std::tuple_cat( std::make_tuple( me ), tu ) );
+    return std::apply( scaleWith< Clock, Ts... >, std::tuple_cat( std::make_tuple( me ), tu ) );
+}
+
+// which points of the grid spanned by the scaling parameters a sweep measures
+struct Sampling
+{
+    enum Kind
+    {
+        // every point (the cartesian product)
+        Grid,
+        // `points` distinct points drawn uniformly from the grid
+        Random,
+        // `points` points stratified so that every dimension's range is covered evenly even
+        // when `points` is far below the grid size; where the strata coincide in every
+        // dimension (a grid coarser than `points`), uniformly drawn points make up the count
+        LatinHypercube,
+    };
+
+    Kind kind{ Grid };
+    size_t points{ 0 };
+    std::uint64_t seed{ 0x5eed };
+
+    static Sampling random( size_t n, std::uint64_t seed = 0x5eed )
+    {
+        return { Random, n, seed };
+    }
+
+    static Sampling latinHypercube( size_t n, std::uint64_t seed = 0x5eed )
+    {
+        return { LatinHypercube, n, seed };
+    }
+};
+
+// the index of a value along each dimension of the grid
+template < size_t N >
+using GridIndex = std::array< size_t, N >;
+
+// the chosen points in lexicographic order (the first dimension varying slowest), i.e. in the
+// order scale() visits the full grid
+template < size_t N >
+std::vector< GridIndex< N > > selectPoints( const GridIndex< N >& sizes, const Sampling& sampling )
+{
+    std::uint64_t total{ 1 };
+    for ( auto size : sizes )
+    {
+        total *= size;
+    }
+    std::vector< GridIndex< N > > points;
+    if ( sampling.kind == Sampling::Grid || sampling.points >= total )
+    {
+        points.reserve( total );
+        GridIndex< N > index{};
+        for ( std::uint64_t linear = 0; linear < total; ++linear )
+        {
+            points.push_back( index );
+            for ( size_t d = N; d-- > 0 && ++index[ d ] == sizes[ d ]; )
+            {
+                index[ d ] = 0;
+            }
+        }
+        return points;
+    }
+    std::mt19937_64 eng( sampling.seed );
+    // Floyd's algorithm: k distinct values below `range` in increasing order, without
+    // materializing the range
+    auto drawDistinct = [ &eng ]( std::uint64_t range, std::uint64_t k ) {
+        std::vector< std::uint64_t > drawn;
+        for ( auto j = range - k; j < range; ++j )
+        {
+            auto t = std::uniform_int_distribution< std::uint64_t >( 0, j )( eng );
+            auto at = std::lower_bound( drawn.begin(), drawn.end(), t );
+            if ( at != drawn.end() && *at == t )
+            {
+                // j is above everything drawn so far
+                drawn.push_back( j );
+            }
+            else
+            {
+                drawn.insert( at, t );
+            }
+        }
+        return drawn;
+    };
+    // the linear positions of the chosen points, sorted and distinct
+    std::vector< std::uint64_t > chosen;
+    if ( sampling.kind == Sampling::Random )
+    {
+        chosen = drawDistinct( total, sampling.points );
+    }
+    else
+    {
+        // every dimension is cut into `points` strata, visited once each in a random order
+        auto n = sampling.points;
+        std::array< std::vector< size_t >, N > strata;
+        for ( auto& permutation : strata )
+        {
+            permutation.resize( n );
+            std::iota( permutation.begin(), permutation.end(), 0 );
+            std::shuffle( permutation.begin(), permutation.end(), eng );
+        }
+        for ( size_t i = 0; i < n; ++i )
+        {
+            std::uint64_t linear{ 0 };
+            for ( size_t d = 0; d < N; ++d )
+            {
+                auto lo = strata[ d ][ i ] * sizes[ d ] / n;
+                auto hi = std::max( lo + 1, ( strata[ d ][ i ] + 1 ) * sizes[ d ] / n );
+                linear = linear * sizes[ d ]
+                         + std::uniform_int_distribution< size_t >( lo, hi - 1 )( eng );
+            }
+            chosen.push_back( linear );
+        }
+        std::sort( chosen.begin(), chosen.end() );
+        chosen.erase( std::unique( chosen.begin(), chosen.end() ), chosen.end() );
+        // where every dimension has fewer values than strata, points can coincide; they are
+        // replaced by points drawn uniformly from the rest of the grid (the r-th of which is
+        // found by skipping the chosen positions up to it)
+        std::vector< std::uint64_t > extra;
+        for ( auto r : drawDistinct( total - chosen.size(), n - chosen.size() ) )
+        {
+            for ( auto c : chosen )
+            {
+                r += c <= r ? 1 : 0;
+            }
+            extra.push_back( r );
+        }
+        auto middle = chosen.insert( chosen.end(), extra.cbegin(), extra.cend() );
+        std::inplace_merge( chosen.begin(), middle, chosen.end() );
+    }
+    points.reserve( chosen.size() );
+    for ( auto linear : chosen )
+    {
+        GridIndex< N > index{};
+        for ( size_t d = N; d-- > 0; )
+        {
+            index[ d ] = static_cast< size_t >( linear % sizes[ d ] );
+            linear /= sizes[ d ];
+        }
+        points.push_back( index );
+    }
+    return points;
+}
+
+// the values a parameter yields, in order
+template < typename T >
+std::vector< T > valuesOf( ScalingParam< T >& parameter )
+{
+    std::vector< T > values;
+    for ( auto i = parameter.begin(); !parameter.end( i ); i = parameter.next( i ) )
+    {
+        values.push_back( i );
+    }
+    return values;
+}
+
+// lay out the record tree of the points [first, last) (sorted) without measuring anything
+template < size_t D, typename Values, size_t N >
+void layout( RecordMultiDim<>&,
+             const std::array< std::string, N >&,
+             const Values&,
+             const std::vector< GridIndex< N > >&,
+             size_t,
+             size_t )
+{
+}
+
+template < size_t D, typename Values, size_t N, typename T, typename... Ts >
+void layout( RecordMultiDim< T, Ts... >& record,
+             const std::array< std::string, N >& labels,
+             const Values& values,
+             const std::vector< GridIndex< N > >& points,
+             size_t first,
+             size_t last )
+{
+    record.label = labels[ D ];
+    for ( auto i = first; i < last; )
+    {
+        auto j = i;
+        while ( j < last && points[ j ][ D ] == points[ i ][ D ] )
+        {
+            ++j;
+        }
+        record.fields.emplace_back( std::get< D >( values )[ points[ i ][ D ] ],
+                                    RecordMultiDim< Ts... >{} );
+        layout< D + 1 >( std::get< 1 >( record.fields.back() ), labels, values, points, i, j );
+        i = j;
+    }
+}
+
+// the leaves of a record tree in the same depth-first order as layout() lays out the points
+inline void collectLeaves( RecordMultiDim<>& record, std::vector< RecordMultiDim<>* >& leaves )
+{
+    leaves.push_back( &record );
+}
+
+template < typename T, typename... Ts >
+void collectLeaves( RecordMultiDim< T, Ts... >& record, std::vector< RecordMultiDim<>* >& leaves )
+{
+    for ( auto& field : record.fields )
+    {
+        collectLeaves( std::get< 1 >( field ), leaves );
+    }
+}
+
+template < typename Values, size_t N, size_t... Is >
+auto pointAt( const Values& values, const GridIndex< N >& index, std::index_sequence< Is... > )
+{
+    return std::make_tuple( std::get< Is >( values )[ index[ Is ] ]... );
+}
+
+// the labels and values of the scaling parameters plus the grid points a sweep measures
+template < typename... Ts >
+struct Sweep
+{
+    std::array< std::string, sizeof...( Ts ) > labels{};
+    std::tuple< std::vector< Ts >... > values{};
+    std::vector< GridIndex< sizeof...( Ts ) > > indices{};
+
+    [[nodiscard]] Param< Ts... > pointAt( size_t i ) const
+    {
+        return Scaling::pointAt( values, indices[ i ], std::index_sequence_for< Ts... >{} );
+    }
+
+    // the outermost dimension in which point i differs from point i - 1, 0 for the first
+    [[nodiscard]] size_t divergenceAt( size_t i ) const
+    {
+        size_t d{ 0 };
+        while ( i > 0 && d + 1 < sizeof...( Ts ) && indices[ i ][ d ] == indices[ i - 1 ][ d ] )
+        {
+            ++d;
+        }
+        return d;
+    }
+};
+
+template < typename... Ts >
+Sweep< Ts... > sweep( std::tuple< LabelledParameter< Ts >... > tu, const Sampling& sampling )
+{
+    constexpr auto N = sizeof...( Ts );
+    Sweep< Ts... > s{};
+    s.labels = std::apply(
+        []( const auto&... parameters ) {
+            return std::array< std::string, N >{ std::get< 0 >( parameters )... };
+        },
+        tu );
+    s.values = std::apply(
+        []( const auto&... parameters ) {
+            return std::make_tuple( valuesOf( *std::get< 1 >( parameters ) )... );
+        },
+        tu );
+    auto sizes = std::apply(
+        []( const auto&... vs ) { return GridIndex< N >{ vs.size()... }; }, s.values );
+    s.indices = selectPoints( sizes, sampling );
+    return s;
+}
+
+// the record tree of the sampled points plus the arguments of each, in the order of the leaves
+template < typename... Ts >
+struct Plan
+{
+    RecordMultiDim< Ts... > record{};
+    std::vector< Param< Ts... > > points{};
+    std::vector< RecordMultiDim<>* > leaves{};
+};
+
+template < typename... Ts >
+void plan( Plan< Ts... >& p, std::tuple< LabelledParameter< Ts >... > tu, const Sampling& sampling )
+{
+    auto s = sweep( tu, sampling );
+    layout< 0 >( p.record, s.labels, s.values, s.indices, 0, s.indices.size() );
+    collectLeaves( p.record, p.leaves );
+    for ( size_t i = 0; i < s.indices.size(); ++i )
+    {
+        p.points.push_back( s.pointAt( i ) );
+    }
+}
+
+// measure every point on worker threads, each pinned to its own physical core (never two SMT
+// siblings), handing the records to done( i, record ) from the worker that measured them
+template < typename Clock, typename... Ts, typename Done >
+void measureParallel( const Impl::BasicMeasurable< Clock, Ts... >& me,
+                      const std::vector< Param< Ts... > >& points,
+                      size_t workers,
+                      const std::vector< int >& cpus,
+                      Done&& done )
+{
+    auto cores = Affinity::isolatedCores( cpus );
+    if ( workers == 0 || workers > cores.size() )
+    {
+        workers = cores.size();
+    }
+    cores.resize( workers );
+    if ( cores.empty() )
+    {
+        cores.push_back( -1 );
+    }
+
+    std::atomic< size_t > next{ 0 };
+    auto work = [ & ]( int cpu ) {
+        auto pinned = cpu >= 0 && Affinity::pinCurrentThread( cpu );
+        for ( auto i = next++; i < points.size(); i = next++ )
+        {
+            auto r = std::apply( &Impl::BasicMeasurable< Clock, Ts... >::measureRecord,
+                                 std::tuple_cat( std::make_tuple( me ), points[ i ] ) );
+            r.cpu = pinned ? cpu : -1;
+            done( i, std::move( r ) );
+        }
+    };
+    std::vector< std::thread > threads;
+    for ( auto cpu : cores )
+    {
+        threads.emplace_back( work, cpu );
+    }
+    for ( auto& thread : threads )
+    {
+        thread.join();
+    }
+}
+
+// measure only the points the sampling picks, e.g. Sampling::latinHypercube( 50 ) to explore a
+// large grid with a bounded number of runs; the record tree holds the measured points only
+template < typename Clock, typename... Ts >
+RecordMultiDim< Ts... > scaleSampledTu( Impl::BasicMeasurable< Clock, Ts... > me,
+                                        std::tuple< LabelledParameter< Ts >... > tu,
+                                        const Sampling& sampling )
+{
+    Plan< Ts... > p{};
+    plan( p, tu, sampling );
+    for ( size_t i = 0; i < p.points.size(); ++i )
+    {
+        *p.leaves[ i ] = std::apply( &Impl::BasicMeasurable< Clock, Ts... >::measureRecord,
+                                     std::tuple_cat( std::make_tuple( me ), p.points[ i ] ) );
+    }
+    return std::move( p.record );
+}
+
+// measure the grid points on pinned worker threads (see measureParallel()) and put the results
+// into the same record tree scale() produces; every record notes the cpu it ran on. The task and
+// its init/setup routines run concurrently and must be thread-safe. Without any pinnable core
+// (e.g. outside Linux) the sweep runs on one unpinned worker.
+template < typename Clock, typename... Ts >
+RecordMultiDim< Ts... > scaleParallelTu( Impl::BasicMeasurable< Clock, Ts... > me,
+                                         std::tuple< LabelledParameter< Ts >... > tu,
+                                         size_t workers = 0,
+                                         const std::vector< int >& cpus = {},
+                                         const Sampling& sampling = {} )
+{
+    Plan< Ts... > p{};
+    plan( p, tu, sampling );
+    measureParallel( me, p.points, workers, cpus, [ &p ]( size_t i, RecordMultiDim<>&& r ) {
+        *p.leaves[ i ] = std::move( r );
+    } );
+    return std::move( p.record );
+}
+
+// measure the points the sampling picks (all of them by default) and append them to the store
+// as the rows of the given record, without building a record tree; with `parallel` the points
+// are measured as scaleParallelTu() does
+template < typename Clock, typename... Ts >
+void scaleInto( ResultStore< Ts... >& store,
+                std::uint32_t recordIndex,
+                const Impl::BasicMeasurable< Clock, Ts... >& me,
+                std::tuple< LabelledParameter< Ts >... > tu,
+                const Sampling& sampling = {},
+                bool parallel = false,
+                size_t workers = 0,
+                const std::vector< int >& cpus = {} )
+{
+    auto s = sweep( tu, sampling );
+    store.withDimensionLabels( s.labels );
+    if ( !parallel )
+    {
+        for ( size_t i = 0; i < s.indices.size(); ++i )
+        {
+            store.append( recordIndex,
+                          s.pointAt( i ),
+                          s.divergenceAt( i ),
+                          std::apply( &Impl::BasicMeasurable< Clock, Ts... >::measureRecord,
+                                      std::tuple_cat( std::make_tuple( me ), s.pointAt( i ) ) ) );
+        }
+        return;
+    }
+    std::vector< Param< Ts... > > points;
+    for ( size_t i = 0; i < s.indices.size(); ++i )
+    {
+        points.push_back( s.pointAt( i ) );
+    }
+    std::vector< RecordMultiDim<> > records( points.size() );
+    measureParallel( me, points, workers, cpus, [ &records ]( size_t i, RecordMultiDim<>&& r ) {
+        records[ i ] = std::move( r );
+    } );
+    for ( size_t i = 0; i < records.size(); ++i )
+    {
+        store.append( recordIndex, points[ i ], s.divergenceAt( i ), records[ i ] );
+    }
 }
 
 }  // namespace AutoTimer::Scaling
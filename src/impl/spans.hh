@@ -0,0 +1,413 @@
+//
+// Created by weining on 18/10/26.
+//
+
+#ifndef AUTOTIMER_SPANS_HH
+#define AUTOTIMER_SPANS_HH
+
+#include "export.hh"
+#include "time_record.hh"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace AutoTimer::Spans
+{
+using LabelId = std::uint32_t;
+
+// the compact record a span timer leaves behind on scope exit; timestamps are nanoseconds
+// since the steady clock's epoch
+struct SpanRecord
+{
+    LabelId label{};
+    std::uint32_t thread{};
+    std::int64_t begin{};
+    std::int64_t end{};
+};
+
+// single-producer single-consumer ring: the owning thread pushes, the drainer pops
+template < typename T, std::size_t Capacity >
+class RingBuffer
+{
+    static_assert( Capacity > 0 && ( Capacity & ( Capacity - 1 ) ) == 0,
+                   "capacity must be a power of two" );
+
+public:
+    bool tryPush( const T& x )
+    {
+        auto h = head.load( std::memory_order_relaxed );
+        if ( h - cachedTail == Capacity )
+        {
+            cachedTail = tail.load( std::memory_order_acquire );
+            if ( h - cachedTail == Capacity )
+            {
+                return false;
+            }
+        }
+        slots[ h & ( Capacity - 1 ) ] = x;
+        head.store( h + 1, std::memory_order_release );
+        return true;
+    }
+
+    template < typename Function >
+    std::size_t drain( Function&& f )
+    {
+        auto t = tail.load( std::memory_order_relaxed );
+        auto h = head.load( std::memory_order_acquire );
+        for ( auto i = t; i != h; ++i )
+        {
+            f( slots[ i & ( Capacity - 1 ) ] );
+        }
+        tail.store( h, std::memory_order_release );
+        return h - t;
+    }
+
+private:
+    alignas( 64 ) std::atomic< std::size_t > head{ 0 };
+    std::size_t cachedTail{ 0 };
+    alignas( 64 ) std::atomic< std::size_t > tail{ 0 };
+    std::array< T, Capacity > slots{};
+};
+
+struct ThreadBuffer
+{
+    std::uint32_t thread{};
+    std::atomic< std::uint64_t > dropped{ 0 };
+    // set by the owning thread on exit, after its last push; the buffer is released after the
+    // next drain
+    std::atomic< bool > retired{ false };
+    RingBuffer< SpanRecord, 4096 > ring{};
+};
+
+// receives every drained span on the drainer thread (or on whoever calls flush())
+struct SpanSink
+{
+    virtual void consume( const SpanRecord& span ) = 0;
+    virtual ~SpanSink() = default;
+};
+
+// interns span labels so the hot path only carries a 32-bit id
+class LabelRegistry
+{
+public:
+    LabelId intern( const std::string& s )
+    {
+        std::lock_guard< std::mutex > lock( mu );
+        auto found = ids.find( s );
+        if ( found != ids.end() )
+        {
+            return found->second;
+        }
+        auto id = static_cast< LabelId >( names.size() );
+        names.push_back( s );
+        ids.emplace( s, id );
+        return id;
+    }
+
+    [[nodiscard]] std::string name( LabelId id ) const
+    {
+        std::lock_guard< std::mutex > lock( mu );
+        return id < names.size() ? names[ id ] : std::string{};
+    }
+
+private:
+    mutable std::mutex mu;
+    std::vector< std::string > names;
+    std::unordered_map< std::string, LabelId > ids;
+};
+
+// a thread's cache of interned labels keyed by address, so a string literal is interned once;
+// a hit is confirmed by the content, so a reused address (e.g. the c_str() of a changing
+// std::string) is interned afresh instead of returning a stale label
+class LabelCache
+{
+public:
+    LabelId lookup( const char* s, LabelRegistry& registry )
+    {
+        auto found = entries.find( s );
+        if ( found != entries.end() && found->second.name == s )
+        {
+            return found->second.id;
+        }
+        auto id = registry.intern( s );
+        entries[ s ] = { id, s };
+        return id;
+    }
+
+private:
+    struct Entry
+    {
+        LabelId id{};
+        std::string name{};
+    };
+
+    std::unordered_map< const char*, Entry > entries;
+};
+
+// per-label count/total/min/max, formatted the same way Report renders its summaries
+class SpanAggregator : public SpanSink
+{
+public:
+    void consume( const SpanRecord& span ) override
+    {
+        if ( span.label >= stats.size() )
+        {
+            stats.resize( span.label + 1 );
+        }
+        auto& s = stats[ span.label ];
+        auto d = span.end - span.begin;
+        s.total += d;
+        s.min = s.count ? std::min( s.min, d ) : d;
+        s.max = s.count ? std::max( s.max, d ) : d;
+        s.count += 1;
+    }
+
+    [[nodiscard]] std::vector< Summary > summaries( const LabelRegistry& labels ) const
+    {
+        std::vector< Summary > xs;
+        for ( LabelId id = 0; id < stats.size(); ++id )
+        {
+            const auto& s = stats[ id ];
+            if ( s.count == 0 )
+            {
+                continue;
+            }
+            xs.emplace_back( labels.name( id ),
+                             s.count,
+                             Duration( s.total / static_cast< std::int64_t >( s.count ) ),
+                             Duration( s.min ),
+                             Duration( s.max ) );
+        }
+        return xs;
+    }
+
+private:
+    struct Stat
+    {
+        std::size_t count{};
+        std::int64_t total{};
+        std::int64_t min{};
+        std::int64_t max{};
+    };
+
+    std::vector< Stat > stats;
+};
+
+// owns the per-thread buffers and the background thread that drains them into the sinks
+class SpanCollector
+{
+public:
+    static SpanCollector& instance()
+    {
+        static SpanCollector collector;
+        return collector;
+    }
+
+    LabelRegistry& labels()
+    {
+        return labelRegistry;
+    }
+
+    // the calling thread's buffer, registered (and the drainer started) on first use and
+    // retired when the thread exits
+    ThreadBuffer& localBuffer()
+    {
+        struct Local
+        {
+            std::shared_ptr< ThreadBuffer > buffer;
+
+            ~Local()
+            {
+                buffer->retired.store( true, std::memory_order_release );
+            }
+        };
+        thread_local Local local{ registerThread() };
+        return *local.buffer;
+    }
+
+    LabelId localLabel( const char* s )
+    {
+        thread_local LabelCache cache;
+        return cache.lookup( s, labelRegistry );
+    }
+
+    void addSink( std::shared_ptr< SpanSink > sink )
+    {
+        std::lock_guard< std::mutex > lock( drainMu );
+        sinks.push_back( std::move( sink ) );
+    }
+
+    void withFlushInterval( std::chrono::milliseconds interval )
+    {
+        std::lock_guard< std::mutex > lock( wakeMu );
+        flushInterval = interval;
+    }
+
+    void withReportOnExit( std::ostream* output )
+    {
+        std::lock_guard< std::mutex > lock( drainMu );
+        reportStream = output;
+    }
+
+    // drain every buffer synchronously; spans recorded before the call are visible afterwards.
+    // The buffers of exited threads are released once drained
+    void flush()
+    {
+        std::vector< std::shared_ptr< ThreadBuffer > > snapshot;
+        {
+            std::lock_guard< std::mutex > lock( buffersMu );
+            snapshot = buffers;
+        }
+        std::vector< ThreadBuffer* > released;
+        {
+            std::lock_guard< std::mutex > lock( drainMu );
+            for ( auto& buffer : snapshot )
+            {
+                // read before draining: a retired thread pushed its last span before retiring
+                auto retired = buffer->retired.load( std::memory_order_acquire );
+                buffer->ring.drain( [ this ]( const SpanRecord& span ) {
+                    aggregator.consume( span );
+                    for ( auto& sink : sinks )
+                    {
+                        sink->consume( span );
+                    }
+                } );
+                if ( retired )
+                {
+                    released.push_back( buffer.get() );
+                }
+            }
+        }
+        if ( released.empty() )
+        {
+            return;
+        }
+        std::lock_guard< std::mutex > lock( buffersMu );
+        auto last = std::remove_if( buffers.begin(), buffers.end(), [ & ]( const auto& buffer ) {
+            if ( std::find( released.begin(), released.end(), buffer.get() ) == released.end() )
+            {
+                return false;
+            }
+            releasedDropped += buffer->dropped.load( std::memory_order_relaxed );
+            return true;
+        } );
+        buffers.erase( last, buffers.end() );
+    }
+
+    [[nodiscard]] std::uint64_t dropped()
+    {
+        std::lock_guard< std::mutex > lock( buffersMu );
+        std::uint64_t n{ releasedDropped };
+        for ( const auto& buffer : buffers )
+        {
+            n += buffer->dropped.load( std::memory_order_relaxed );
+        }
+        return n;
+    }
+
+    // the buffers still held: those of running threads plus exited ones not yet drained
+    [[nodiscard]] std::size_t liveBuffers()
+    {
+        std::lock_guard< std::mutex > lock( buffersMu );
+        return buffers.size();
+    }
+
+    [[nodiscard]] std::vector< Summary > summaries()
+    {
+        flush();
+        std::lock_guard< std::mutex > lock( drainMu );
+        return aggregator.summaries( labelRegistry );
+    }
+
+    std::ostream& formatted( std::ostream& os, AutoTimer::TimeUnitOptions opt )
+    {
+        for ( const auto& summary : summaries() )
+        {
+            renderCastedSummary( os, 0, opt, RecordMultiDim<>( summary ).castSummary( opt ) )
+                << '\n';
+        }
+        if ( auto n = dropped() )
+        {
+            os << "(" << n << " spans dropped)\n";
+        }
+        return os;
+    }
+
+    ~SpanCollector()
+    {
+        {
+            std::lock_guard< std::mutex > lock( wakeMu );
+            stopping = true;
+        }
+        wake.notify_all();
+        if ( drainer.joinable() )
+        {
+            drainer.join();
+        }
+        if ( reportStream && numThreads )
+        {
+            formatted( *reportStream, TimeUnitOptions::MicroSecond );
+        }
+    }
+
+private:
+    SpanCollector() = default;
+
+    std::shared_ptr< ThreadBuffer > registerThread()
+    {
+        auto buffer = std::make_shared< ThreadBuffer >();
+        std::lock_guard< std::mutex > lock( buffersMu );
+        buffer->thread = numThreads++;
+        buffers.push_back( buffer );
+        if ( !drainer.joinable() )
+        {
+            drainer = std::thread( [ this ]() { drainLoop(); } );
+        }
+        return buffer;
+    }
+
+    void drainLoop()
+    {
+        std::unique_lock< std::mutex > lock( wakeMu );
+        while ( !stopping )
+        {
+            wake.wait_for( lock, flushInterval, [ this ]() { return stopping; } );
+            lock.unlock();
+            flush();
+            lock.lock();
+        }
+    }
+
+    LabelRegistry labelRegistry;
+
+    std::mutex buffersMu;
+    std::vector< std::shared_ptr< ThreadBuffer > > buffers;
+    std::uint32_t numThreads{ 0 };
+    std::uint64_t releasedDropped{ 0 };
+
+    std::mutex drainMu;
+    SpanAggregator aggregator;
+    std::vector< std::shared_ptr< SpanSink > > sinks;
+    std::ostream* reportStream{ &std::cout };
+
+    std::mutex wakeMu;
+    std::condition_variable wake;
+    std::chrono::milliseconds flushInterval{ 10 };
+    bool stopping{ false };
+    std::thread drainer;
+};
+
+}  // namespace AutoTimer::Spans
+
+#endif  // AUTOTIMER_SPANS_HH
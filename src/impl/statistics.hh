@@ -0,0 +1,299 @@
+//
+// Created by weining on 18/10/26.
+//
+
+#ifndef AUTOTIMER_STATISTICS_HH
+#define AUTOTIMER_STATISTICS_HH
+
+#include "time_record.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+
+namespace AutoTimer::Stats
+{
+using namespace AutoTimer::TimeRecord;
+
+// linear interpolation between the closest ranks; xs must be sorted
+template < typename T >
+double percentile( const std::vector< T >& xs, double q )
+{
+    if ( xs.empty() )
+    {
+        return 0.0;
+    }
+    auto pos = q * static_cast< double >( xs.size() - 1 );
+    auto lo = static_cast< size_t >( std::floor( pos ) );
+    auto hi = std::min( lo + 1, xs.size() - 1 );
+    auto frac = pos - static_cast< double >( lo );
+    auto at = []( const T& x ) {
+        if constexpr ( std::is_arithmetic_v< T > )
+        {
+            return static_cast< double >( x );
+        }
+        else
+        {
+            return static_cast< double >( x.count() );
+        }
+    };
+    return at( xs[ lo ] ) + ( at( xs[ hi ] ) - at( xs[ lo ] ) ) * frac;
+}
+
+inline double mean( const std::vector< double >& xs )
+{
+    double sum{ 0 };
+    for ( auto x : xs )
+    {
+        sum += x;
+    }
+    return xs.empty() ? 0.0 : sum / static_cast< double >( xs.size() );
+}
+
+inline double stddev( const std::vector< double >& xs )
+{
+    if ( xs.size() < 2 )
+    {
+        return 0.0;
+    }
+    auto m = mean( xs );
+    double sq{ 0 };
+    for ( auto x : xs )
+    {
+        sq += ( x - m ) * ( x - m );
+    }
+    return std::sqrt( sq / static_cast< double >( xs.size() - 1 ) );
+}
+
+// Tukey's fences: samples beyond 1.5 (mild) or 3 (severe) interquartile ranges from the
+// quartiles; ds must be sorted
+inline Outliers classifyOutliers( const std::vector< Duration >& ds )
+{
+    Outliers o{};
+    if ( ds.size() < 4 )
+    {
+        return o;
+    }
+    auto q1 = percentile( ds, 0.25 );
+    auto q3 = percentile( ds, 0.75 );
+    auto iqr = q3 - q1;
+    for ( auto d : ds )
+    {
+        auto x = static_cast< double >( d.count() );
+        if ( x < q1 - 3 * iqr )
+        {
+            ++o.lowSevere;
+        }
+        else if ( x < q1 - 1.5 * iqr )
+        {
+            ++o.lowMild;
+        }
+        else if ( x > q3 + 3 * iqr )
+        {
+            ++o.highSevere;
+        }
+        else if ( x > q3 + 1.5 * iqr )
+        {
+            ++o.highMild;
+        }
+    }
+    return o;
+}
+
+// remove the outliers the policy asks for, keeping ds sorted
+inline void rejectOutliers( std::vector< Duration >& ds, OutlierRejection rejection )
+{
+    if ( rejection == OutlierRejection::None || ds.size() < 4 )
+    {
+        return;
+    }
+    auto q1 = percentile( ds, 0.25 );
+    auto q3 = percentile( ds, 0.75 );
+    auto fence = ( rejection == OutlierRejection::Severe ? 3.0 : 1.5 ) * ( q3 - q1 );
+    ds.erase( std::remove_if( ds.begin(),
+                              ds.end(),
+                              [ lo = q1 - fence, hi = q3 + fence ]( Duration d ) {
+                                  auto x = static_cast< double >( d.count() );
+                                  return x < lo || x > hi;
+                              } ),
+              ds.end() );
+}
+
+// the width of the normal-approximation 95% confidence interval of the mean relative to the
+// mean; cheap enough to re-evaluate after every round of adaptive sampling
+inline double relativeIntervalWidth( const std::vector< Duration >& ds )
+{
+    if ( ds.size() < 2 )
+    {
+        return std::numeric_limits< double >::infinity();
+    }
+    double sum{ 0 };
+    double sq{ 0 };
+    for ( auto d : ds )
+    {
+        auto x = static_cast< double >( d.count() );
+        sum += x;
+        sq += x * x;
+    }
+    auto n = static_cast< double >( ds.size() );
+    auto m = sum / n;
+    if ( m <= 0 )
+    {
+        return std::numeric_limits< double >::infinity();
+    }
+    auto variance = std::max( ( sq - n * m * m ) / ( n - 1 ), 0.0 );
+    return 2 * 1.96 * std::sqrt( variance / n ) / m;
+}
+
+// the percentile bootstrap of the mean and the median; xs must be sorted. Beyond `budget`
+// sample draws the samples are large enough for the normal approximation of the mean and the
+// distribution-free order-statistic interval of the median, which are used instead
+inline void bootstrap( const std::vector< double >& xs,
+                       size_t resamples,
+                       Interval& meanInterval,
+                       Interval& medianInterval,
+                       size_t budget = 10000000 )
+{
+    if ( xs.size() < 2 || resamples == 0 )
+    {
+        return;
+    }
+    auto toDuration = []( double x ) { return Duration( std::llround( x ) ); };
+    if ( xs.size() * resamples > budget )
+    {
+        auto n = static_cast< double >( xs.size() );
+        auto m = mean( xs );
+        auto half = 1.96 * stddev( xs ) / std::sqrt( n );
+        meanInterval = { toDuration( m - half ), toDuration( m + half ) };
+        auto spread = 1.96 * std::sqrt( n ) / 2;
+        auto lo = static_cast< size_t >( std::max( n / 2 - spread, 0.0 ) );
+        auto hi = std::min( static_cast< size_t >( std::ceil( n / 2 + spread ) ), xs.size() - 1 );
+        medianInterval = { toDuration( xs[ lo ] ), toDuration( xs[ hi ] ) };
+        return;
+    }
+    std::mt19937_64 eng( 0x5eed );
+    std::uniform_int_distribution< size_t > pick( 0, xs.size() - 1 );
+    std::vector< double > means( resamples );
+    std::vector< double > medians( resamples );
+    std::vector< double > draw( xs.size() );
+    for ( size_t b = 0; b < resamples; ++b )
+    {
+        double sum{ 0 };
+        for ( auto& x : draw )
+        {
+            x = xs[ pick( eng ) ];
+            sum += x;
+        }
+        means[ b ] = sum / static_cast< double >( draw.size() );
+        auto mid = draw.begin() + draw.size() / 2;
+        std::nth_element( draw.begin(), mid, draw.end() );
+        medians[ b ] = *mid;
+    }
+    std::sort( means.begin(), means.end() );
+    std::sort( medians.begin(), medians.end() );
+    meanInterval = { toDuration( percentile( means, 0.025 ) ),
+                     toDuration( percentile( means, 0.975 ) ) };
+    medianInterval = { toDuration( percentile( medians, 0.025 ) ),
+                       toDuration( percentile( medians, 0.975 ) ) };
+}
+
+// the outcome of a one-sided Mann-Whitney U test
+struct RankTest
+{
+    // the probability of a difference at least this large if neither sample tends to be smaller
+    double pValue{ 1.0 };
+    // the common-language effect size: the probability that a value drawn from the first sample
+    // is smaller than one drawn from the second (ties counting half)
+    double probabilitySmaller{ 0.5 };
+};
+
+// whether xs tends to be smaller than ys, by the normal approximation of the U statistic with
+// tie and continuity corrections; distribution-free, so skewed timing samples are fine
+inline RankTest mannWhitney( const std::vector< double >& xs, const std::vector< double >& ys )
+{
+    RankTest t{};
+    if ( xs.empty() || ys.empty() )
+    {
+        return t;
+    }
+    std::vector< std::pair< double, bool > > pooled;
+    for ( auto x : xs )
+    {
+        pooled.emplace_back( x, true );
+    }
+    for ( auto y : ys )
+    {
+        pooled.emplace_back( y, false );
+    }
+    std::sort( pooled.begin(), pooled.end() );
+
+    // the rank sum of xs with ties sharing their average rank
+    double rankSum{ 0 };
+    double ties{ 0 };
+    for ( size_t i = 0; i < pooled.size(); )
+    {
+        auto j = i;
+        size_t fromXs{ 0 };
+        for ( ; j < pooled.size() && pooled[ j ].first == pooled[ i ].first; ++j )
+        {
+            fromXs += pooled[ j ].second;
+        }
+        auto rank = static_cast< double >( i + j + 1 ) / 2;
+        rankSum += rank * static_cast< double >( fromXs );
+        auto tied = static_cast< double >( j - i );
+        ties += tied * tied * tied - tied;
+        i = j;
+    }
+    auto n1 = static_cast< double >( xs.size() );
+    auto n2 = static_cast< double >( ys.size() );
+    auto n = n1 + n2;
+    // the number of pairs in which x is larger
+    auto u = rankSum - n1 * ( n1 + 1 ) / 2;
+    t.probabilitySmaller = 1 - u / ( n1 * n2 );
+    auto variance = n1 * n2 / 12 * ( ( n + 1 ) - ties / ( n * ( n - 1 ) ) );
+    if ( variance <= 0 )
+    {
+        return t;
+    }
+    auto z = ( u - n1 * n2 / 2 + 0.5 ) / std::sqrt( variance );
+    t.pValue = 0.5 * std::erfc( -z / std::sqrt( 2.0 ) );
+    return t;
+}
+
+// median, tail percentiles, spread and 95% bootstrap confidence intervals; ds must be sorted
+inline Statistics describe( const std::vector< Duration >& ds, size_t resamples = 1000 )
+{
+    Statistics s{};
+    if ( ds.empty() )
+    {
+        return s;
+    }
+    auto toDuration = []( double x ) { return Duration( std::llround( x ) ); };
+    s.median = toDuration( percentile( ds, 0.5 ) );
+    s.p90 = toDuration( percentile( ds, 0.9 ) );
+    s.p99 = toDuration( percentile( ds, 0.99 ) );
+    s.p999 = toDuration( percentile( ds, 0.999 ) );
+
+    std::vector< double > xs( ds.size() );
+    std::transform( ds.cbegin(), ds.cend(), xs.begin(), []( Duration d ) {
+        return static_cast< double >( d.count() );
+    } );
+    s.stddev = toDuration( stddev( xs ) );
+
+    std::vector< double > deviations( xs.size() );
+    auto median = static_cast< double >( s.median.count() );
+    std::transform( xs.cbegin(), xs.cend(), deviations.begin(), [ median ]( double x ) {
+        return std::abs( x - median );
+    } );
+    std::sort( deviations.begin(), deviations.end() );
+    s.mad = toDuration( percentile( deviations, 0.5 ) );
+
+    bootstrap( xs, resamples, s.meanInterval, s.medianInterval );
+    return s;
+}
+
+}  // namespace AutoTimer::Stats
+
+#endif  // AUTOTIMER_STATISTICS_HH
@@ -5,10 +5,13 @@
 #ifndef AUTOTIMER_TIME_RECORD_HH
 #define AUTOTIMER_TIME_RECORD_HH
 
+#include "histogram.hh"
 #include "utilities.hh"
 
+#include <array>
 #include <chrono>
 #include <tuple>
+#include <vector>
 
 namespace AutoTimer
 {
@@ -16,6 +19,44 @@ enum class TimeUnitOptions
 {
     MicroSecond,
     MilliSecond,
+    NanoSecond,
+};
+
+enum class OutputFormat
+{
+    // the human readable report
+    Text,
+    // one document holding a row per record, durations in nanoseconds
+    Json,
+    // a header line plus one line per record, durations in nanoseconds
+    Csv,
+};
+
+// the growth models Analytic::fitComplexity() chooses from, in increasing order
+enum class Complexity
+{
+    O1,
+    OLogN,
+    ON,
+    ONLogN,
+    ON2,
+    ON3,
+};
+
+// what a regression against a persisted baseline does (see Baseline::compare())
+enum class RegressionAction
+{
+    Fail,
+    Warn,
+};
+
+enum class OutlierRejection
+{
+    None,
+    // drop samples beyond the outer fences
+    Severe,
+    // drop samples beyond the inner fences
+    All,
 };
 
 namespace TimeRecord
@@ -38,6 +79,141 @@ SummaryCasted durationCast( Summary s )
                             duration_cast< Precision >( std::get< 4 >( s ) ).count() );
 }
 
+inline size_t castDuration( Duration d, TimeUnitOptions opt )
+{
+    using namespace std::chrono;
+    if ( opt == TimeUnitOptions::MicroSecond )
+    {
+        return duration_cast< microseconds >( d ).count();
+    }
+    else if ( opt == TimeUnitOptions::MilliSecond )
+    {
+        return duration_cast< milliseconds >( d ).count();
+    }
+    else
+    {
+        return duration_cast< nanoseconds >( d ).count();
+    }
+}
+
+struct Interval
+{
+    Duration lower{};
+    Duration upper{};
+};
+
+// the distribution of the samples behind a summary (see Stats::describe())
+struct Statistics
+{
+    Duration median{};
+    Duration p90{};
+    Duration p99{};
+    Duration p999{};
+    Duration stddev{};
+    Duration mad{};
+
+    // 95% bootstrap confidence intervals
+    Interval meanInterval{};
+    Interval medianInterval{};
+};
+
+// sample counts beyond Tukey's fences (see Stats::classifyOutliers())
+struct Outliers
+{
+    size_t lowSevere{};
+    size_t lowMild{};
+    size_t highMild{};
+    size_t highSevere{};
+
+    [[nodiscard]] size_t mild() const
+    {
+        return lowMild + highMild;
+    }
+
+    [[nodiscard]] size_t severe() const
+    {
+        return lowSevere + highSevere;
+    }
+};
+
+// event counts per invocation of the task (see Perf::CounterGroup)
+struct Counters
+{
+    enum Event : size_t
+    {
+        Cycles,
+        Instructions,
+        BranchMisses,
+        L1dMisses,
+        LlcMisses,
+        DtlbMisses,
+        TaskClock,
+        PageFaults,
+        ContextSwitches,
+        EventCount,
+    };
+
+    std::array< double, EventCount > perOp{};
+    std::array< bool, EventCount > available{};
+
+    static const char* name( size_t e )
+    {
+        static constexpr const char* names[ EventCount ]{ "cycles",
+                                                          "instructions",
+                                                          "branch-misses",
+                                                          "L1d-misses",
+                                                          "LLC-misses",
+                                                          "dTLB-misses",
+                                                          "task-clock (nano)",
+                                                          "page-faults",
+                                                          "context-switches" };
+        return names[ e ];
+    }
+
+    [[nodiscard]] bool any() const
+    {
+        for ( auto a : available )
+        {
+            if ( a )
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // instructions per cycle, 0 when either is unavailable
+    [[nodiscard]] double ipc() const
+    {
+        return available[ Cycles ] && available[ Instructions ] && perOp[ Cycles ] > 0
+                   ? perOp[ Instructions ] / perOp[ Cycles ]
+                   : 0.0;
+    }
+};
+
+// heap allocations per invocation of the task (see Allocations::Counter)
+struct AllocationCounts
+{
+    // false unless the program installed the tracking operator new/delete
+    bool tracked{ false };
+    double allocations{};
+    double frees{};
+    double bytes{};
+};
+
+// a record measured on several threads at once (see BasicMeasurable::withThreads())
+struct Contention
+{
+    // 0 when the record was measured on the calling thread only
+    size_t threads{};
+    // invocations per second, summed over the threads
+    double opsPerSecond{};
+    // the throughput relative to `threads` times the single-thread throughput
+    double efficiency{};
+    // the mean latency each thread saw
+    std::vector< Duration > perThread{};
+};
+
 // encapsulate the runtime data
 template < typename... Ts >
 struct RecordMultiDim
@@ -55,6 +231,42 @@ struct RecordMultiDim<>
 
     AutoTimer::TimeRecord::Summary summary{};
 
+    // the estimated cost of the timing harness itself, measured with an empty task
+    Duration overhead{};
+    bool nearNoiseFloor{ false };
+
+    // invocations per sample; the summary is per invocation, the batch extremes are per sample
+    size_t batch{ 1 };
+    Duration batchMin{};
+    Duration batchMax{};
+
+    Statistics statistics{};
+
+    size_t warmupRuns{};
+    Outliers outliers{};
+
+    Contention contention{};
+
+    // per-invocation event counts, when requested (see BasicMeasurable::withPerfCounters())
+    Counters counters{};
+
+    // when requested (see BasicMeasurable::withAllocationTracking())
+    AllocationCounts allocations{};
+
+    // every measured sample per invocation in the order taken, when requested (see
+    // BasicMeasurable::withRawSamples())
+    std::vector< Duration > samples{};
+
+    // every measured sample per invocation at a bounded precision and memory, when requested
+    // (see BasicMeasurable::withHistogram())
+    Hdr::Histogram histogram{};
+
+    // the cpu a parallel sweep pinned this record's worker to, -1 when not pinned
+    int cpu{ -1 };
+
+    // false when adaptive sampling ran out of budget before reaching the target precision
+    bool converged{ true };
+
     RecordMultiDim<>() = default;
 
     explicit RecordMultiDim<>( AutoTimer::TimeRecord::Summary summary )
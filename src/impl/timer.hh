@@ -5,40 +5,72 @@
 #ifndef AUTOTIMER_TIMER_HH
 #define AUTOTIMER_TIMER_HH
 
+#include "aggregation.hh"
+#include "call_tree.hh"
+#include "clocks.hh"
+#include "samplers.hh"
+#include "spans.hh"
+
 #include <chrono>
 #include <iostream>
 #include <string>
+#include <type_traits>
 
 namespace AutoTimer
 {
-struct Timer
+#if defined( AUTOTIMER_DISABLE_TIMERS )
+constexpr bool timersEnabled = false;
+#else
+constexpr bool timersEnabled = true;
+#endif
+
+// what every timer below becomes when compiled out: it takes the arguments of the timer it
+// stands in for, holds nothing and reads no clock (a Timer's output pointer is left untouched)
+struct NullTimer
+{
+    template < typename... Args >
+    explicit NullTimer( Args&&... ) noexcept
+    {
+    }
+};
+
+static_assert( std::is_empty_v< NullTimer > );
+
+// the timer if enabled, NullTimer otherwise, e.g. EnabledTimer< kTraceParser, SpanTimer > to
+// switch one component's instrumentation at compile time; defining AUTOTIMER_DISABLE_TIMERS
+// switches off all of them
+template < bool Enabled, typename T >
+using EnabledTimer = std::conditional_t< Enabled, T, NullTimer >;
+
+template < typename Clock >
+struct BasicTimer
 {
     std::string label{};
-    std::chrono::time_point< std::chrono::high_resolution_clock > begin{};
+    typename Clock::time_point begin{};
     std::ostream& os;
     std::size_t* p_out{ nullptr };
     std::size_t target{};
 
-    explicit Timer( std::string s, std::ostream& os_ = std::cout )
+    explicit BasicTimer( std::string s, std::ostream& os_ = std::cout )
         : label{ std::move( s ) }, os{ os_ }
     {
-        begin = std::chrono::high_resolution_clock::now();
+        begin = Impl::sampleStart< Clock >();
     }
 
-    explicit Timer( std::string s,
-                    std::size_t* out,
-                    std::size_t comparison_target = 0,
-                    std::ostream& os_ = std::cout )
+    explicit BasicTimer( std::string s,
+                         std::size_t* out,
+                         std::size_t comparison_target = 0,
+                         std::ostream& os_ = std::cout )
         : label( std::move( s ) ), p_out( out ), target{ comparison_target }, os{ os_ }
     {
-        begin = std::chrono::high_resolution_clock::now();
+        begin = Impl::sampleStart< Clock >();
     }
 
-    ~Timer()
+    ~BasicTimer()
     {
         using namespace std;
         using namespace chrono;
-        auto d{ high_resolution_clock::now() - begin };
+        auto d{ Impl::sampleStop< Clock >() - begin };
         // TypeTester<decltype(d)>{};
         std::size_t count = std::chrono::duration_cast< microseconds >( d ).count();
         if ( p_out )
@@ -62,6 +94,142 @@ struct Timer
         std::cout.imbue( locale );
     }
 };
+
+using Timer = EnabledTimer< timersEnabled, BasicTimer< DefaultClock > >;
+
+namespace Impl
+{
+// leaves a compact span record in a per-thread ring buffer on scope exit; the spans are
+// aggregated by label on a background thread and reported when the program exits
+// (see Spans::SpanCollector)
+struct SpanTimer
+{
+    Spans::LabelId label{};
+    std::chrono::time_point< std::chrono::steady_clock > begin{};
+
+    // the label is interned once per thread and cached by its address (confirmed by the
+    // content, see Spans::LabelCache)
+    explicit SpanTimer( const char* s )
+        : label( Spans::SpanCollector::instance().localLabel( s ) )
+    {
+        begin = std::chrono::steady_clock::now();
+    }
+
+    explicit SpanTimer( Spans::LabelId id ) : label( id )
+    {
+        begin = std::chrono::steady_clock::now();
+    }
+
+    ~SpanTimer()
+    {
+        auto end = std::chrono::steady_clock::now();
+        auto& buffer = Spans::SpanCollector::instance().localBuffer();
+        auto ns = []( auto t ) {
+            using namespace std::chrono;
+            return duration_cast< TimeRecord::Duration >( t.time_since_epoch() ).count();
+        };
+        Spans::SpanRecord span{ label, buffer.thread, ns( begin ), ns( end ) };
+        if ( !buffer.ring.tryPush( span ) )
+        {
+            buffer.dropped.fetch_add( 1, std::memory_order_relaxed );
+        }
+    }
+};
+
+// a node in the calling thread's call tree: nested ProfileTimers become children of the
+// enclosing one, and the trees of all threads are merged into one report at exit
+// (see Profile::CallTreeRegistry); timed with steady_clock, like the SpanTimer
+struct ProfileTimer
+{
+    Profile::ThreadTree& tree;
+    Profile::CallNode* node{ nullptr };
+    std::chrono::time_point< std::chrono::steady_clock > begin{};
+
+    explicit ProfileTimer( const char* s )
+        : tree( Profile::CallTreeRegistry::instance().localTree() )
+    {
+        {
+            std::lock_guard< std::mutex > lock( tree.mu );
+            node = tree.stack.back()->child( s );
+            tree.stack.push_back( node );
+        }
+        begin = std::chrono::steady_clock::now();
+    }
+
+    ~ProfileTimer()
+    {
+        auto d = std::chrono::steady_clock::now() - begin;
+        std::lock_guard< std::mutex > lock( tree.mu );
+        node->record( d );
+        tree.stack.pop_back();
+        tree.stack.back()->childTime += d;
+    }
+};
+}  // namespace Impl
+
+// adds its duration to the calling thread's histogram of the label on scope exit, without
+// formatting anything or touching another thread's data; the per-thread statistics are merged
+// into one line per label on demand, periodically or at exit (see Aggregation::Registry)
+template < typename Clock >
+struct BasicAggregatingTimer
+{
+    Aggregation::Shard& shard;
+    Spans::LabelId label{};
+    typename Clock::time_point begin{};
+
+    // the label is interned once per thread and cached by its address (confirmed by the
+    // content, see Spans::LabelCache)
+    explicit BasicAggregatingTimer( const char* s )
+        : shard( Aggregation::Registry::instance().localShard() ),
+          label( Aggregation::Registry::instance().localLabel( s ) )
+    {
+        begin = Impl::sampleStart< Clock >();
+    }
+
+    ~BasicAggregatingTimer()
+    {
+        auto d = Impl::sampleStop< Clock >() - begin;
+        shard.record( label, std::chrono::duration_cast< TimeRecord::Duration >( d ) );
+    }
+};
+
+// times only the scopes the sampler picks (see Samplers, e.g. Samplers::OneIn< 100 >) and adds
+// them to the aggregating registry as AggregatingTimer does; the other scopes cost the sampler's
+// decision and no clock read. The registry's counts are those of the sampled scopes
+template < typename Sampler, typename Clock >
+struct BasicSamplingTimer
+{
+    bool sampled{ false };
+    Spans::LabelId label{};
+    typename Clock::time_point begin{};
+
+    explicit BasicSamplingTimer( const char* s ) : sampled( Sampler::take() )
+    {
+        if ( sampled )
+        {
+            label = Aggregation::Registry::instance().localLabel( s );
+            begin = Impl::sampleStart< Clock >();
+        }
+    }
+
+    ~BasicSamplingTimer()
+    {
+        if ( sampled )
+        {
+            auto d = Impl::sampleStop< Clock >() - begin;
+            Aggregation::Registry::instance().localShard().record(
+                label, std::chrono::duration_cast< TimeRecord::Duration >( d ) );
+        }
+    }
+};
+
+using SpanTimer = EnabledTimer< timersEnabled, Impl::SpanTimer >;
+using ProfileTimer = EnabledTimer< timersEnabled, Impl::ProfileTimer >;
+using AggregatingTimer = EnabledTimer< timersEnabled, BasicAggregatingTimer< DefaultClock > >;
+
+template < typename Sampler >
+using SamplingTimer = EnabledTimer< timersEnabled, BasicSamplingTimer< Sampler, DefaultClock > >;
+
 }  // namespace AutoTimer
 
 #endif  // AUTOTIMER_TIMER_HH
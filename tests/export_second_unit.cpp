@@ -0,0 +1,18 @@
+//
+// Created by weining on 18/10/26.
+//
+
+// a second translation unit of test_export including the library, so that the test fails to
+// link if a header defines a non-template function without inline
+
+#include <sstream>
+#include <string>
+
+#include "autotimer.hh"
+
+std::string renderedInSecondUnit( const AutoTimer::RecordMultiDim<>& record )
+{
+    std::ostringstream oss;
+    AutoTimer::renderRecordDetails( oss, 2, AutoTimer::TimeUnitOptions::NanoSecond, record );
+    return oss.str();
+}
@@ -0,0 +1,84 @@
+//
+// Created by weining on 18/10/26.
+//
+
+#ifndef AUTOTIMER_TESTS_RECORDS_HH
+#define AUTOTIMER_TESTS_RECORDS_HH
+
+#include "autotimer.hh"
+
+#include <algorithm>
+#include <numeric>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+// hand-built records for the tests of what consumes them (the exporters, the analytics, the
+// baselines, the result store), independent of any timing
+namespace TestRecords
+{
+using namespace AutoTimer;
+
+// a leaf with the given summary, no statistics and no samples
+inline RecordMultiDim<> leaf(
+    const std::string& label, long mean, size_t runs = 1, long fastest = 0, long slowest = 0 )
+{
+    return RecordMultiDim<>{ std::make_tuple(
+        label, runs, Duration( mean ), Duration( fastest ), Duration( slowest ) ) };
+}
+
+// a leaf summarising and describing the given samples, which it keeps
+inline RecordMultiDim<> sampled( const std::string& label, std::vector< Duration > samples )
+{
+    auto mean = std::accumulate( samples.cbegin(), samples.cend(), Duration{} )
+                / static_cast< long >( samples.size() );
+    auto [ fastest, slowest ] = std::minmax_element( samples.cbegin(), samples.cend() );
+    auto r = leaf( label, mean.count(), samples.size(), fastest->count(), slowest->count() );
+    auto ordered = samples;
+    std::sort( ordered.begin(), ordered.end() );
+    r.statistics = Stats::describe( ordered, 0 );
+    r.samples = std::move( samples );
+    return r;
+}
+
+// a "sort" leaf between 1 and 9 nanoseconds whose mean and median are the given one, keeping
+// the given samples
+inline RecordMultiDim<> sorted( long mean, std::vector< Duration > samples )
+{
+    auto r = leaf( "sort", mean, samples.size(), 1, 9 );
+    r.statistics.median = Duration( mean );
+    r.samples = std::move( samples );
+    return r;
+}
+
+// the same with n samples, all of them the mean
+inline RecordMultiDim<> sorted( long mean, size_t n )
+{
+    return sorted( mean, std::vector< Duration >( n, Duration( mean ) ) );
+}
+
+// the same with the samples 1, mean and 9
+inline RecordMultiDim<> sorted( long mean )
+{
+    return sorted( mean, { Duration( 1 ), Duration( mean ), Duration( 9 ) } );
+}
+
+// a record along one scaling dimension, e.g. along< int >( "n", { { 10, leaf( ... ) } } ); name
+// the inner dimensions' types too for a nested one
+template < typename T, typename... Ts >
+RecordMultiDim< T, Ts... > along( const std::string& dimension,
+                                  std::vector< std::pair< T, RecordMultiDim< Ts... > > > fields )
+{
+    RecordMultiDim< T, Ts... > r{};
+    r.label = dimension;
+    for ( auto& [ x, field ] : fields )
+    {
+        r.fields.emplace_back( x, std::move( field ) );
+    }
+    return r;
+}
+
+}  // namespace TestRecords
+
+#endif  // AUTOTIMER_TESTS_RECORDS_HH
@@ -0,0 +1,115 @@
+//
+// Created by weining on 18/10/26.
+//
+
+#include "impl/aggregation.hh"
+#include "impl/timer.hh"
+
+#include <cassert>
+#include <chrono>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+void handle()
+{
+    AutoTimer::AggregatingTimer atm( "handle()" );
+}
+
+void test_merged_across_threads()
+{
+    auto& registry = AutoTimer::Aggregation::Registry::instance();
+    registry.withReportOnExit( nullptr );
+
+    std::vector< std::thread > workers;
+    for ( int t = 0; t < 4; ++t )
+    {
+        workers.emplace_back( []() {
+            for ( int i = 0; i < 1000; ++i )
+            {
+                handle();
+            }
+            AutoTimer::AggregatingTimer atm( "parse()" );
+        } );
+    }
+    for ( auto& worker : workers )
+    {
+        worker.join();
+    }
+
+    auto entries = registry.snapshot();
+    assert( entries.size() == 2 );
+    assert( entries[ 0 ].label == "handle()" && entries[ 0 ].stats.histogram.count() == 4000 );
+    assert( entries[ 1 ].label == "parse()" && entries[ 1 ].stats.histogram.count() == 4 );
+    auto summary = entries[ 0 ].stats.summary( entries[ 0 ].label );
+    assert( std::get< 1 >( summary ) == 4000 );
+    assert( std::get< 3 >( summary ) <= std::get< 2 >( summary ) );
+    assert( std::get< 2 >( summary ) <= std::get< 4 >( summary ) );
+
+    std::ostringstream oss;
+    registry.formatted( oss, AutoTimer::TimeUnitOptions::NanoSecond, true );
+    assert( oss.str().find( "handle(): " ) == 0 );
+    assert( oss.str().find( "(4000 runs, " ) != std::string::npos );
+    assert( oss.str().find( ", p99.9: " ) != std::string::npos );
+    // reset by the report
+    assert( registry.snapshot().empty() );
+}
+
+void test_periodic_report()
+{
+    auto& registry = AutoTimer::Aggregation::Registry::instance();
+    std::ostringstream oss;
+    handle();
+    registry.withPeriodicReport( &oss, std::chrono::milliseconds( 1 ) );
+    std::this_thread::sleep_for( std::chrono::milliseconds( 20 ) );
+    registry.withPeriodicReport( nullptr, {} );
+    assert( oss.str().find( "handle(): " ) != std::string::npos );
+}
+
+void test_sampling_timer()
+{
+    auto& registry = AutoTimer::Aggregation::Registry::instance();
+    ( void )registry.snapshot( true );
+    for ( int i = 0; i < 1000; ++i )
+    {
+        AutoTimer::SamplingTimer< AutoTimer::Samplers::OneIn< 10 > > atm( "every tenth" );
+    }
+    size_t taken{ 0 };
+    for ( int i = 0; i < 10000; ++i )
+    {
+        AutoTimer::SamplingTimer< AutoTimer::Samplers::Probability< 100000 > > atm( "p = 0.1" );
+        taken += AutoTimer::Samplers::Probability< 500000 >::take();
+    }
+    for ( int i = 0; i < 1000; ++i )
+    {
+        AutoTimer::SamplingTimer< AutoTimer::Samplers::RateLimited< 1 > > atm( "once a second" );
+    }
+    auto entries = registry.snapshot();
+    assert( entries.size() == 3 );
+    assert( entries[ 0 ].label == "every tenth" && entries[ 0 ].stats.histogram.count() == 100 );
+    auto p = entries[ 1 ].stats.histogram.count();
+    assert( entries[ 1 ].label == "p = 0.1" && p > 800 && p < 1200 );
+    assert( taken > 4500 && taken < 5500 );
+    assert( entries[ 2 ].stats.histogram.count() == 1 );
+}
+
+void test_label_cache_checks_reused_addresses()
+{
+    auto& registry = AutoTimer::Aggregation::Registry::instance();
+    std::string name{ "first" };
+    auto first = registry.localLabel( name.c_str() );
+    name.replace( 0, 5, "other" );
+    auto other = registry.localLabel( name.c_str() );
+    assert( first != other );
+    assert( registry.labels().name( other ) == "other" );
+}
+
+int main()
+{
+    test_merged_across_threads();
+    test_periodic_report();
+    test_sampling_timer();
+    test_label_cache_checks_reused_addresses();
+    return 0;
+}
@@ -0,0 +1,87 @@
+//
+// Created by weining on 18/10/26.
+//
+
+#define AUTOTIMER_TRACK_ALLOCATIONS
+#include "autotimer.hh"
+
+#include <cassert>
+#include <memory>
+#include <sstream>
+#include <vector>
+
+void test_counter_sees_the_calling_thread()
+{
+    assert( AutoTimer::Allocations::installed() );
+    AutoTimer::Allocations::Counter counter{};
+    counter.start();
+    {
+        auto p = std::make_unique< long >( 1 );
+        AutoTimer::doNotOptimize( p.get() );
+    }
+    counter.stop();
+    auto c = counter.read( 1 );
+    assert( c.tracked );
+    assert( c.allocations == 1 );
+    assert( c.frees == 1 );
+    assert( c.bytes == sizeof( long ) );
+}
+
+void test_measure_reports_allocations_per_invocation()
+{
+    auto me = AutoTimer::Impl::Measurable<>( []() {
+                  std::vector< int > xs( 16 );
+                  AutoTimer::doNotOptimize( xs.data() );
+              } )
+                  .withMultiplier( 10 )
+                  .withBatch( 4 )
+                  .withAllocationTracking();
+    auto r = me.measureRecord();
+    assert( r.allocations.tracked );
+    assert( r.allocations.allocations == 1 );
+    assert( r.allocations.frees == 1 );
+    assert( r.allocations.bytes == 16 * sizeof( int ) );
+
+    std::ostringstream oss;
+    AutoTimer::render( oss, 0, AutoTimer::TimeUnitOptions::NanoSecond, r );
+    assert( oss.str().find( "allocations per op: 1.00 (64.00 bytes), frees: 1.00" )
+            != std::string::npos );
+}
+
+void test_untracked_measure_reports_nothing()
+{
+    auto me = AutoTimer::Impl::Measurable<>( []() { std::make_unique< int >( 1 ); } );
+    auto r = me.measureRecord();
+    assert( !r.allocations.tracked );
+}
+
+void test_assert_no_more_allocations()
+{
+    std::vector< int > xs( 1024, 1 );
+    AutoTimer::Builder()
+        .withLabel( "allocation-free hot path" )
+        .withMultiplier( 10 )
+        .measure( [ &xs ]() {
+            long sum{ 0 };
+            for ( auto x : xs )
+            {
+                sum += x;
+            }
+            return sum;
+        } )
+        .assertNoMoreAllocations();
+
+    AutoTimer::Builder()
+        .withLabel( "at most one allocation" )
+        .measure( []() { return std::make_unique< int >( 1 ); } )
+        .assertNoMoreAllocations( 1 );
+}
+
+int main()
+{
+    test_counter_sees_the_calling_thread();
+    test_measure_reports_allocations_per_invocation();
+    test_untracked_measure_reports_nothing();
+    test_assert_no_more_allocations();
+    return 0;
+}
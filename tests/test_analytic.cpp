@@ -0,0 +1,208 @@
+//
+// Created by weining on 18/10/26.
+//
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "autotimer.hh"
+#include "records.hh"
+
+using namespace AutoTimer;
+using namespace TestRecords;
+
+// n samples from `from` to `from` + 4
+RecordMultiDim<> noisy( const char* label, long from, size_t n )
+{
+    std::vector< Duration > ds;
+    for ( size_t i = 0; i < n; ++i )
+    {
+        ds.emplace_back( from + static_cast< long >( i % 5 ) );
+    }
+    return sampled( label, ds );
+}
+
+void test_significant_speedup()
+{
+    Report<> report{};
+    report.timeRecords = { noisy( "base", 100, 20 ),
+                           noisy( "faster", 80, 20 ),
+                           noisy( "same", 100, 20 ) };
+    auto speedups = Analytic::compareWithFirst( report );
+    assert( speedups.size() == 2 );
+    assert( speedups[ 0 ].candidate == "faster" && speedups[ 0 ].tested && speedups[ 0 ].passed );
+    assert( speedups[ 0 ].ratio > 1.2 );
+    // equal within noise is not faster
+    assert( speedups[ 1 ].tested && !speedups[ 1 ].passed );
+
+    // 1.25x faster, but not 1.5x
+    assert( Analytic::compareWithFirst( report, 1.2 )[ 0 ].passed );
+    assert( !Analytic::compareWithFirst( report, 1.5 )[ 0 ].passed );
+
+    std::ostringstream oss;
+    Analytic::renderSpeedups( oss, "", Analytic::compareWithFirst( report ) );
+    assert( oss.str().find( "faster speedup: 1.2" ) == 0 );
+    assert( oss.str().find( "same speedup: 1.0000x, p: " ) != std::string::npos );
+    assert( oss.str().find( ", failed\n" ) != std::string::npos );
+}
+
+void test_too_few_samples_fall_back_to_means()
+{
+    Report<> report{};
+    report.timeRecords = { noisy( "base", 100, 2 ), noisy( "faster", 99, 2 ) };
+    auto speedups = Analytic::compareWithFirst( report );
+    assert( !speedups[ 0 ].tested && speedups[ 0 ].passed );
+}
+
+void test_compare_per_scaling_point()
+{
+    auto scaled = []( long at1, long at2 ) {
+        return along< int >( "n", { { 1, noisy( "", at1, 10 ) }, { 2, noisy( "", at2, 10 ) } } );
+    };
+    Report< int > report{};
+    report.timeRecords = { scaled( 100, 100 ), scaled( 50, 200 ) };
+    auto speedups = Analytic::compareWithFirst( report );
+    assert( speedups.size() == 2 );
+    assert( speedups[ 0 ].candidate == "measure 2" && speedups[ 0 ].point == "n=1" );
+    assert( speedups[ 0 ].passed );
+    assert( speedups[ 1 ].point == "n=2" && !speedups[ 1 ].passed );
+}
+
+void test_assert_faster_with_required_speedup()
+{
+    std::vector< int > xs( 1 << 14, 1 );
+    AutoTimer::Builder()
+        .withLabel( "visit every 8th element" )
+        .withMultiplier( 20 )
+        .measure( "all", [ &xs ]() {
+            long sum{ 0 };
+            for ( size_t i = 0; i < xs.size(); ++i )
+            {
+                sum += xs[ i ] * static_cast< long >( i );
+                AutoTimer::doNotOptimize( sum );
+            }
+            return sum;
+        } )
+        .measure( "every 8th", [ &xs ]() {
+            long sum{ 0 };
+            for ( size_t i = 0; i < xs.size(); i += 8 )
+            {
+                sum += xs[ i ] * static_cast< long >( i );
+                AutoTimer::doNotOptimize( sum );
+            }
+            return sum;
+        } )
+        .assertFaster( 2 );
+}
+
+void test_fit_complexity_models()
+{
+    std::vector< double > ns{ 1, 2, 4, 8, 16, 32, 64, 128, 256, 512, 1024 };
+    auto times = [ &ns ]( auto f ) {
+        std::vector< double > ts;
+        for ( auto n : ns )
+        {
+            ts.push_back( f( n ) );
+        }
+        return ts;
+    };
+    auto best = []( const std::vector< Analytic::Fit >& fits ) { return fits.front().model; };
+    assert( best( Analytic::fitComplexity( ns, times( []( double ) { return 7.0; } ) ) )
+            == Complexity::O1 );
+    assert( best( Analytic::fitComplexity( ns, times( []( double n ) { return 3 * n; } ) ) )
+            == Complexity::ON );
+    assert( best( Analytic::fitComplexity(
+                ns, times( []( double n ) { return 2 * n * std::log2( n ) + 1; } ) ) )
+            == Complexity::ONLogN );
+    // a linear time with 10% noise and a 60% excursion at the largest size: an absolute least
+    // squares fit would let that one point pick O(n^2)
+    std::vector< double > noise{ 1.1, 0.9, 1.05, 0.95, 1.1, 0.9, 1.0, 1.05, 0.95, 1.0, 1.6 };
+    std::vector< double > noisyLinear;
+    for ( size_t i = 0; i < ns.size(); ++i )
+    {
+        noisyLinear.push_back( 50 * ns[ i ] * noise[ i ] );
+    }
+    assert( best( Analytic::fitComplexity( ns, noisyLinear ) ) == Complexity::ON );
+    auto quadratic = Analytic::fitComplexity( ns, times( []( double n ) { return 0.5 * n * n; } ) );
+    assert( best( quadratic ) == Complexity::ON2 );
+    assert( std::abs( quadratic.front().coefficient - 0.5 ) < 1e-9 );
+    assert( quadratic.front().rms < 1e-9 );
+}
+
+void test_fit_slices_and_assert_complexity()
+{
+    RecordMultiDim< int > linear{};
+    linear.label = "n";
+    for ( int n : { 10, 100, 1000, 10000 } )
+    {
+        linear.fields.emplace_back( n, leaf( "scan", 5 * n ) );
+    }
+    Report< std::string, int > report{};
+    report.timeRecords.push_back(
+        along< std::string, int >( "mode", { { "cold", linear }, { "warm", linear } } ) );
+    auto fits = Analytic::fitSlices( report );
+    assert( fits.size() == 2 );
+    assert( fits[ 1 ].measure == "scan" && fits[ 1 ].dimension == "n" );
+    assert( fits[ 1 ].point == "mode=warm" && fits[ 1 ].points == 4 );
+    assert( fits[ 1 ].best.model == Complexity::ON );
+    assert( Analytic::scalesNoWorseThan( fits[ 1 ], Complexity::ONLogN ) );
+    assert( !Analytic::scalesNoWorseThan( fits[ 1 ], Complexity::OLogN ) );
+
+    std::ostringstream oss;
+    Analytic::renderFits( oss, "", fits );
+    assert( oss.str().find( "scan (mode=cold) over n: O(n), coefficient: 5 nano, rms: 0.0%\n" )
+            == 0 );
+
+    // the slow outlier at the largest size inflates its mean, not its median
+    RecordMultiDim< int > outlying{};
+    outlying.label = "n";
+    for ( long n : { 10, 100, 1000, 10000 } )
+    {
+        std::vector< Duration > ds( 9, Duration( 5 * n ) );
+        ds.emplace_back( n == 10000 ? 5 * n * 100 : 5 * n );
+        outlying.fields.emplace_back( static_cast< int >( n ), sampled( "fill", ds ) );
+    }
+    Report< int > filled{};
+    filled.timeRecords.push_back( outlying );
+    auto fill = Analytic::fitSlices( filled ).front();
+    assert( fill.best.model == Complexity::ON && fill.best.rms < 1e-9 );
+    assert( Analytic::scalesNoWorseThan( fill, Complexity::ONLogN ) );
+}
+
+void test_fit_slices_per_measure_in_one_dimension()
+{
+    auto sweep = []( const char* label, auto time ) {
+        RecordMultiDim< int > record{};
+        record.label = "n";
+        for ( int n : { 100, 200, 400, 800 } )
+        {
+            record.fields.emplace_back( n, leaf( label, time( n ) ) );
+        }
+        return record;
+    };
+    Report< int > report{};
+    report.timeRecords = { sweep( "linear", []( int n ) { return 3 * n; } ),
+                           sweep( "const", []( int ) { return 50; } ) };
+    auto fits = Analytic::fitSlices( report );
+    assert( fits.size() == 2 );
+    assert( fits[ 0 ].measure == "linear" && fits[ 0 ].points == 4 );
+    assert( fits[ 0 ].best.model == Complexity::ON );
+    assert( fits[ 1 ].measure == "const" && fits[ 1 ].points == 4 );
+    assert( fits[ 1 ].best.model == Complexity::O1 );
+}
+
+int main()
+{
+    test_significant_speedup();
+    test_too_few_samples_fall_back_to_means();
+    test_compare_per_scaling_point();
+    test_assert_faster_with_required_speedup();
+    test_fit_complexity_models();
+    test_fit_slices_and_assert_complexity();
+    test_fit_slices_per_measure_in_one_dimension();
+    return 0;
+}
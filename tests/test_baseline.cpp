@@ -0,0 +1,141 @@
+//
+// Created by weining on 18/10/26.
+//
+
+#include <cassert>
+#include <cstdio>
+#include <sstream>
+#include <string>
+
+#include "autotimer.hh"
+#include "records.hh"
+
+using namespace AutoTimer;
+using namespace TestRecords;
+
+Report< int > reportWithMedians( long small, long large )
+{
+    Report< int > report{};
+    report.label = "suite";
+    report.timeRecords.push_back(
+        along< int >( "size", { { 1, sorted( small ) }, { 100, sorted( large ) } } ) );
+    return report;
+}
+
+void test_save_and_load_round_trip()
+{
+    const std::string path{ "test_baseline_round_trip.tsv" };
+    std::remove( path.c_str() );
+    assert( Baseline::load( path ).empty() );
+
+    auto table = Baseline::collect( reportWithMedians( 10, 1000 ) );
+    assert( table.size() == 2 );
+    assert( table.count( "suite\tsort\tsize=100" ) == 1 );
+    assert( Baseline::save( path, table ) );
+
+    // saving merges with what is there
+    Baseline::Table other{};
+    other[ "other\tmeasure\t" ] = Baseline::Entry{ Duration( 5 ), Duration( 6 ) };
+    assert( Baseline::save( path, other ) );
+    auto loaded = Baseline::load( path );
+    assert( loaded.size() == 3 );
+    assert( loaded[ "suite\tsort\tsize=100" ].median == Duration( 1000 ) );
+    assert( loaded[ "other\tmeasure\t" ].mean == Duration( 6 ) );
+    std::remove( path.c_str() );
+}
+
+void test_compare_with_tolerance()
+{
+    auto baseline = Baseline::collect( reportWithMedians( 10, 1000 ) );
+    auto current = Baseline::collect( reportWithMedians( 14, 1050 ) );
+    current[ "suite\tsort\tsize=1000" ] = Baseline::Entry{ Duration( 1 ), Duration( 1 ) };
+    auto comparisons = Baseline::compare( current, baseline, 0.1 );
+    assert( comparisons.size() == 3 );
+    for ( const auto& c : comparisons )
+    {
+        if ( c.key == "suite\tsort\tsize=1" )
+        {
+            assert( c.status == Baseline::Comparison::Regressed );
+        }
+        else if ( c.key == "suite\tsort\tsize=100" )
+        {
+            assert( c.status == Baseline::Comparison::Unchanged );
+        }
+        else
+        {
+            assert( c.status == Baseline::Comparison::New );
+        }
+    }
+    std::ostringstream oss;
+    assert( Baseline::renderComparisons( oss, "", comparisons ) == 1 );
+    assert( oss.str() == "regressed: sort size=1 1.40x (median 14 vs 10 nano)\n" );
+}
+
+void test_builder_records_then_compares()
+{
+    const std::string path{ "test_baseline_builder.tsv" };
+    std::remove( path.c_str() );
+    for ( int run = 0; run < 2; ++run )
+    {
+        std::ostringstream oss;
+        {
+            Builder()
+                .withLabel( "baseline" )
+                .withOutputStream( oss )
+                .withBaseline( path, 0.1, RegressionAction::Warn )
+                .measure( "slept", []() {
+                    std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+                } );
+        }
+        assert( oss.str().find( "baseline: failed" ) == std::string::npos );
+    }
+    auto loaded = Baseline::load( path );
+    assert( loaded.size() == 1 );
+    assert( loaded.begin()->first == "baseline\tslept\t" );
+    assert( loaded.begin()->second.median >= std::chrono::milliseconds( 1 ) );
+
+    // a much slower run is reported (as a warning here)
+    std::ostringstream oss;
+    {
+        Builder()
+            .withLabel( "baseline" )
+            .withOutputStream( oss )
+            .withBaseline( path, 0.1, RegressionAction::Warn )
+            .measure( "slept", []() {
+                std::this_thread::sleep_for( std::chrono::milliseconds( 20 ) );
+            } );
+    }
+    assert( oss.str().find( "regressed: slept" ) != std::string::npos );
+    std::remove( path.c_str() );
+}
+
+void test_keys_are_unique()
+{
+    const std::string path{ "test_baseline_keys.tsv" };
+    std::remove( path.c_str() );
+    std::ostringstream oss;
+    {
+        BasicBuilder< int >( Scaling::makeConstant( "n", 5, 2 ) )
+            .withLabel( "keys" )
+            .withOutputStream( oss )
+            .withBaseline( path )
+            .measure( []( int ) {} )
+            .measure( []( int ) {} );
+    }
+    auto loaded = Baseline::load( path );
+    assert( loaded.size() == 4 );
+    assert( loaded.count( "keys\tmeasure 1\tn=5" ) == 1 );
+    assert( loaded.count( "keys\tmeasure 1\tn=5 #2" ) == 1 );
+    assert( loaded.count( "keys\tmeasure 2\tn=5" ) == 1 );
+    assert( loaded.count( "keys\tmeasure 2\tn=5 #2" ) == 1 );
+    std::remove( path.c_str() );
+}
+
+int main()
+{
+    test_save_and_load_round_trip();
+    test_compare_with_tolerance();
+    test_keys_are_unique();
+    test_builder_records_then_compares();
+    return 0;
+}
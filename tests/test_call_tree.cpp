@@ -0,0 +1,79 @@
+//
+// Created by weining on 18/10/26.
+//
+
+#include "impl/call_tree.hh"
+#include "impl/timer.hh"
+
+#include <algorithm>
+#include <cassert>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+void load()
+{
+    AutoTimer::ProfileTimer atm( "load()" );
+}
+
+void compute()
+{
+    AutoTimer::ProfileTimer atm( "compute()" );
+    load();
+    load();
+}
+
+void test_nested_timers_form_a_tree_merged_across_threads()
+{
+    auto& registry = AutoTimer::Profile::CallTreeRegistry::instance();
+    registry.withReportOnExit( nullptr );
+
+    std::vector< std::thread > workers;
+    for ( int t = 0; t < 3; ++t )
+    {
+        workers.emplace_back( []() {
+            compute();
+            load();
+        } );
+    }
+    for ( auto& worker : workers )
+    {
+        worker.join();
+    }
+
+    auto root = registry.merged();
+    assert( root.children.size() == 2 );
+    const auto& top = *root.children[ 0 ];
+    assert( top.label == "compute()" );
+    assert( top.count == 3 );
+    assert( top.children.size() == 1 );
+    assert( top.children[ 0 ]->count == 6 );
+    assert( top.inclusive >= top.self() );
+    assert( top.childTime == top.children[ 0 ]->inclusive );
+    assert( root.children[ 1 ]->label == "load()" );
+    assert( root.children[ 1 ]->count == 3 );
+
+    std::ostringstream oss;
+    registry.formatted( oss, AutoTimer::TimeUnitOptions::MicroSecond );
+    assert( oss.str().find( "    load(): " ) != std::string::npos );
+}
+
+void test_child_lookup_checks_reused_addresses()
+{
+    AutoTimer::Profile::CallNode root;
+    char name[] = "parse()";
+    auto parse = root.child( name );
+    std::copy_n( "write()", 8, name );
+    auto write = root.child( name );
+    assert( parse != write );
+    assert( parse->label == "parse()" && write->label == "write()" );
+    assert( root.child( "parse()" ) == parse );
+    assert( root.children.size() == 2 );
+}
+
+int main()
+{
+    test_nested_timers_form_a_tree_merged_across_threads();
+    test_child_lookup_checks_reused_addresses();
+    return 0;
+}
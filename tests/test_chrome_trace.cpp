@@ -0,0 +1,91 @@
+//
+// Created by weining on 18/10/26.
+//
+
+#include "impl/chrome_trace.hh"
+#include "impl/timer.hh"
+
+#include <cassert>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+size_t occurrences( const std::string& s, const std::string& pattern )
+{
+    size_t n{ 0 };
+    for ( auto pos = s.find( pattern ); pos != std::string::npos; pos = s.find( pattern, pos + 1 ) )
+    {
+        ++n;
+    }
+    return n;
+}
+
+void test_complete_events()
+{
+    AutoTimer::Spans::LabelRegistry labels;
+    auto outer = labels.intern( "parse()" );
+    auto inner = labels.intern( "say \"hi\"" );
+
+    std::ostringstream oss;
+    // a tiny buffer forces several chunked writes
+    AutoTimer::Spans::ChromeTraceSink sink( oss, labels, 64 );
+    sink.consume( { inner, 0, 1234567891, 1234568000 } );
+    sink.consume( { outer, 0, 1234000000, 1240000005 } );
+    sink.consume( { outer, 3, 7, 2007 } );
+    sink.close();
+    sink.consume( { outer, 0, 1, 2 } );
+
+    auto s = oss.str();
+    assert( s.find( "{\"traceEvents\": [\n{\"name\": \"thread_name\"" ) == 0 );
+    assert( s.substr( s.size() - 4 ) == "\n]}\n" );
+    assert( occurrences( s, "\"ph\": \"X\"" ) == 3 );
+    assert( occurrences( s, "\"ph\": \"M\"" ) == 2 );
+    assert( occurrences( s, "},\n{" ) == 4 );
+    assert( s.find( "{\"name\": \"say \\\"hi\\\"\", \"ph\": \"X\", \"pid\": 1, \"tid\": 0, "
+                    "\"ts\": 1234567.891, \"dur\": 0.109}" )
+            != std::string::npos );
+    assert( s.find( "\"tid\": 0, \"ts\": 1234000.000, \"dur\": 6000.005}" ) != std::string::npos );
+    assert( s.find( "\"tid\": 3, \"ts\": 0.007, \"dur\": 2.000}" ) != std::string::npos );
+    assert( s.find( "\"args\": {\"name\": \"thread 3\"}" ) != std::string::npos );
+}
+
+void test_nested_span_timers()
+{
+    auto& collector = AutoTimer::Spans::SpanCollector::instance();
+    collector.withReportOnExit( nullptr );
+    std::ostringstream oss;
+    auto sink = std::make_shared< AutoTimer::Spans::ChromeTraceSink >( oss, collector.labels() );
+    collector.addSink( sink );
+
+    std::vector< std::thread > workers;
+    for ( int t = 0; t < 2; ++t )
+    {
+        workers.emplace_back( []() {
+            AutoTimer::SpanTimer outer( "batch()" );
+            for ( int i = 0; i < 3; ++i )
+            {
+                AutoTimer::SpanTimer inner( "item()" );
+            }
+        } );
+    }
+    for ( auto& worker : workers )
+    {
+        worker.join();
+    }
+    collector.flush();
+    sink->close();
+
+    auto s = oss.str();
+    assert( occurrences( s, "{\"name\": \"batch()\", \"ph\": \"X\"" ) == 2 );
+    assert( occurrences( s, "{\"name\": \"item()\", \"ph\": \"X\"" ) == 6 );
+    assert( occurrences( s, "\"name\": \"thread_name\"" ) == 2 );
+    assert( s.substr( s.size() - 4 ) == "\n]}\n" );
+}
+
+int main()
+{
+    test_complete_events();
+    test_nested_span_timers();
+    return 0;
+}
@@ -0,0 +1,44 @@
+//
+// Created by weining on 18/10/26.
+//
+
+#include "impl/clocks.hh"
+#include "impl/measurable.hh"
+
+#include <cassert>
+#include <chrono>
+#include <thread>
+#include <type_traits>
+
+void test_tsc_clock_tracks_steady_clock()
+{
+    using namespace std::chrono;
+    static_assert( AutoTimer::Impl::HasFencedReads< AutoTimer::TscClock >::value );
+    static_assert( !AutoTimer::Impl::HasFencedReads< AutoTimer::DefaultClock >::value );
+
+    auto begin = AutoTimer::TscClock::start();
+    std::this_thread::sleep_for( milliseconds( 20 ) );
+    auto elapsed = duration_cast< milliseconds >( AutoTimer::TscClock::stop() - begin ).count();
+    assert( elapsed >= 15 && elapsed < 2000 );
+    assert( AutoTimer::TscClock::now() >= begin );
+}
+
+void test_measurable_with_tsc_clock()
+{
+    using Measurable = AutoTimer::Impl::BasicMeasurable< AutoTimer::TscClock, int >;
+    static_assert(
+        std::is_same_v< AutoTimer::Impl::Measurable< int >,
+                        AutoTimer::Impl::BasicMeasurable< AutoTimer::DefaultClock, int > > );
+
+    auto summary = Measurable( []( int ) {} ).withMultiplier( 100 ).measure( 1 );
+    assert( std::get< 1 >( summary ) == 100 );
+    assert( std::get< 3 >( summary ) <= std::get< 2 >( summary ) );
+    assert( std::get< 2 >( summary ) <= std::get< 4 >( summary ) );
+}
+
+int main()
+{
+    test_tsc_clock_tracks_steady_clock();
+    test_measurable_with_tsc_clock();
+    return 0;
+}
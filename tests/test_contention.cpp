@@ -0,0 +1,122 @@
+//
+// Created by weining on 18/10/26.
+//
+
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "autotimer.hh"
+
+void test_spin_barrier_releases_everyone()
+{
+    constexpr size_t n = 4;
+    AutoTimer::Impl::SpinBarrier barrier( n );
+    std::atomic< size_t > released{ 0 };
+    std::vector< std::thread > threads;
+    for ( size_t t = 0; t < n; ++t )
+    {
+        threads.emplace_back( [ & ]() {
+            barrier.arriveAndWait();
+            ++released;
+        } );
+    }
+    for ( auto& thread : threads )
+    {
+        thread.join();
+    }
+    assert( released == n );
+}
+
+void test_measure_on_several_threads()
+{
+    std::atomic< size_t > calls{ 0 };
+    auto me = AutoTimer::Impl::Measurable<>( [ &calls ]() { ++calls; } )
+                  .withMultiplier( 10 )
+                  .withThreads( 3 );
+    auto r = me.measureRecord();
+    assert( calls == 30 + 10 );  // plus the single-thread baseline
+    assert( std::get< 1 >( r.summary ) == 30 );
+    assert( r.contention.threads == 3 );
+    assert( r.contention.perThread.size() == 3 );
+    assert( r.contention.opsPerSecond > 0 );
+    assert( r.contention.efficiency > 0 );
+
+    std::ostringstream oss;
+    AutoTimer::render( oss, 0, AutoTimer::TimeUnitOptions::NanoSecond, r );
+    assert( oss.str().find( "threads: 3" ) != std::string::npos );
+    assert( oss.str().find( "per thread:" ) != std::string::npos );
+}
+
+void test_thread_count_as_scaling_dimension()
+{
+    std::ostringstream oss;
+    std::atomic< size_t > calls{ 0 };
+    {
+        AutoTimer::BasicBuilder< int >( AutoTimer::Scaling::makeDiscrete( "threads", 1, 2, 4 ) )
+            .withOutputStream( oss )
+            .withMultiplier( 5 )
+            .withThreads()
+            .measure( [ &calls ]( int ) { ++calls; } );
+    }
+    // 1 thread alone, 2 and 4 threads plus their single-thread baselines
+    assert( calls == 5 * 1 + 5 * ( 2 + 1 ) + 5 * ( 4 + 1 ) );
+    assert( oss.str().find( "threads(4) measure" ) != std::string::npos );
+    assert( oss.str().find( "threads: 4" ) != std::string::npos );
+}
+
+// whether running the builder made by f fails the process, which happens in a child process
+template < typename Function >
+bool exitsWithFailure( Function f )
+{
+    auto pid = fork();
+    if ( pid == 0 )
+    {
+        std::ostringstream oss;
+        f( oss );
+        _exit( 0 );
+    }
+    int status{ 0 };
+    waitpid( pid, &status, 0 );
+    return WIFEXITED( status ) && WEXITSTATUS( status ) == 1;
+}
+
+void test_unsupported_combinations_are_rejected()
+{
+    auto task = []( int ) {};
+    assert( exitsWithFailure( [ task ]( std::ostream& os ) {
+        AutoTimer::BasicBuilder< int >( AutoTimer::Scaling::makeDiscrete( "size", 1, 2 ) )
+            .withOutputStream( os )
+            .withThreads()
+            .measure( task );
+    } ) );
+    assert( exitsWithFailure( [ task ]( std::ostream& os ) {
+        AutoTimer::BasicBuilder< int >( AutoTimer::Scaling::makeDiscrete( "threads", 1, 2 ) )
+            .withOutputStream( os )
+            .withThreads()
+            .withTimeBudget( std::chrono::milliseconds( 1 ) )
+            .measure( task );
+    } ) );
+    assert( exitsWithFailure( []( std::ostream& os ) {
+        AutoTimer::Builder().withOutputStream( os ).withThreads( 2 ).withPerfCounters().measure(
+            []() {} );
+    } ) );
+    assert( !exitsWithFailure( []( std::ostream& os ) {
+        AutoTimer::Builder().withOutputStream( os ).withThreads( 2 ).measure( []() {} );
+    } ) );
+}
+
+int main()
+{
+    test_spin_barrier_releases_everyone();
+    test_measure_on_several_threads();
+    test_thread_count_as_scaling_dimension();
+    test_unsupported_combinations_are_rejected();
+    return 0;
+}
@@ -0,0 +1,41 @@
+//
+// Created by weining on 18/10/26.
+//
+
+#define AUTOTIMER_DISABLE_TIMERS
+
+#include "impl/aggregation.hh"
+#include "impl/timer.hh"
+
+#include <cassert>
+#include <cstddef>
+#include <sstream>
+#include <type_traits>
+
+static_assert( std::is_same_v< AutoTimer::Timer, AutoTimer::NullTimer > );
+static_assert( std::is_same_v< AutoTimer::SpanTimer, AutoTimer::NullTimer > );
+static_assert( std::is_same_v< AutoTimer::ProfileTimer, AutoTimer::NullTimer > );
+static_assert( std::is_same_v< AutoTimer::AggregatingTimer, AutoTimer::NullTimer > );
+static_assert( std::is_same_v< AutoTimer::SamplingTimer< AutoTimer::Samplers::Always >,
+                               AutoTimer::NullTimer > );
+static_assert( std::is_empty_v< AutoTimer::Timer > );
+
+void test_compiled_out_timers_record_nothing()
+{
+    std::ostringstream oss;
+    std::size_t out{ 42 };
+    {
+        AutoTimer::Timer atm( "main()", &out, 0, oss );
+        AutoTimer::AggregatingTimer aggregated( "handle()" );
+        AutoTimer::SamplingTimer< AutoTimer::Samplers::Always > sampled( "handle()" );
+    }
+    assert( oss.str().empty() && out == 42 );
+    assert( AutoTimer::Aggregation::Registry::instance().snapshot().empty() );
+}
+
+int main()
+{
+    AutoTimer::Aggregation::Registry::instance().withReportOnExit( nullptr );
+    test_compiled_out_timers_record_nothing();
+    return 0;
+}
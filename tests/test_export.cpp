@@ -0,0 +1,176 @@
+//
+// Created by weining on 18/10/26.
+//
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+#include <sstream>
+#include <string>
+
+#include "autotimer.hh"
+#include "records.hh"
+
+using namespace AutoTimer;
+using namespace TestRecords;
+
+// defined in export_second_unit.cpp
+std::string renderedInSecondUnit( const RecordMultiDim<>& record );
+
+Report< int, std::string > twoDimensionalReport()
+{
+    auto inner = along< std::string >(
+        "mode", { { "fast", sorted( 10 ) }, { "a \"quoted\", mode", sorted( 20 ) } } );
+    Report< int, std::string > report{};
+    report.label = "export";
+    report.timeRecords.push_back( along< int, std::string >( "size", { { 100, inner } } ) );
+    return report;
+}
+
+void test_flatten_records_with_coordinates()
+{
+    size_t leaves{ 0 };
+    Coordinates coordinates;
+    forEachLeaf( twoDimensionalReport().timeRecords[ 0 ],
+                 coordinates,
+                 [ &leaves ]( const Coordinates& c, const RecordMultiDim<>& ) {
+                     assert( c.size() == 2 );
+                     assert( c[ 0 ].label == "size" && c[ 0 ].value == "100" && c[ 0 ].numeric );
+                     assert( c[ 1 ].label == "mode" && !c[ 1 ].numeric );
+                     ++leaves;
+                 } );
+    assert( leaves == 2 );
+    assert( coordinates.empty() );
+}
+
+void test_json()
+{
+    std::ostringstream oss;
+    twoDimensionalReport().json( oss );
+    auto s = oss.str();
+    assert( s.find( "{\"label\": \"export\", \"records\": [\n" ) == 0 );
+    assert( s.find( "{\"measure\": \"sort\", \"parameters\": {\"size\": 100, \"mode\": \"fast\"}, "
+                    "\"runs\": 3, \"mean_ns\": 10, \"min_ns\": 1, \"max_ns\": 9" )
+            != std::string::npos );
+    assert( s.find( "\"mode\": \"a \\\"quoted\\\", mode\"" ) != std::string::npos );
+    assert( s.find( "\"samples_ns\": [1, 20, 9]" ) != std::string::npos );
+    assert( s.find( "\"converged\": true" ) != std::string::npos );
+    assert( s.substr( s.size() - 4 ) == "\n]}\n" );
+}
+
+void test_csv()
+{
+    std::ostringstream oss;
+    twoDimensionalReport().csv( oss );
+    std::istringstream lines( oss.str() );
+    std::string header, first, second, rest;
+    std::getline( lines, header );
+    std::getline( lines, first );
+    std::getline( lines, second );
+    assert( !std::getline( lines, rest ) );
+    assert( header.find( "measure,size,mode,runs,mean_ns,min_ns,max_ns," ) == 0 );
+    assert( first.find( "sort,100,fast,3,10,1,9," ) == 0 );
+    assert( second.find( "sort,100,\"a \"\"quoted\"\", mode\",3,20,1,9," ) == 0 );
+    assert( second.substr( second.size() - 7 ) == ",1 20 9" );
+}
+
+void test_json_coordinates_are_numbers()
+{
+    auto infinity = std::numeric_limits< double >::infinity();
+    auto nan = std::numeric_limits< double >::quiet_NaN();
+    auto inner = along< double >(
+        "x", { { 0.5, leaf( "m", 1 ) }, { infinity, leaf( "m", 2 ) }, { nan, leaf( "m", 3 ) } } );
+    Report< char, double > report{};
+    report.label = "coordinates";
+    report.timeRecords.push_back( along< char, double >( "c", { { 'A', inner } } ) );
+    std::ostringstream oss;
+    report.json( oss );
+    auto s = oss.str();
+    assert( s.find( "\"parameters\": {\"c\": 65, \"x\": 0.5}" ) != std::string::npos );
+    assert( s.find( "\"parameters\": {\"c\": 65, \"x\": null}, \"runs\": 1, \"mean_ns\": 2" )
+            != std::string::npos );
+    assert( s.find( "\"parameters\": {\"c\": 65, \"x\": null}, \"runs\": 1, \"mean_ns\": 3" )
+            != std::string::npos );
+    assert( s.find( "inf" ) == std::string::npos && s.find( "nan" ) == std::string::npos );
+}
+
+void test_optional_columns_and_precision()
+{
+    auto r = sorted( 10 );
+    r.contention.threads = 4;
+    r.contention.opsPerSecond = 123456789.125;
+    r.contention.efficiency = 1.0 / 3;
+    r.allocations = { true, 2, 2, 64 };
+    Report< double > report{};
+    report.timeRecords.push_back( along< double >( "load", { { 0.1 + 0.2, r } } ) );
+
+    std::ostringstream json;
+    report.json( json );
+    assert( json.str().find( "\"parameters\": {\"load\": 0.30000000000000004}" )
+            != std::string::npos );
+    assert( json.str().find( "\"ops_per_second\": 123456789.125, "
+                             "\"efficiency\": 0.33333333333333331" )
+            != std::string::npos );
+
+    std::ostringstream csv;
+    report.csv( csv );
+    std::istringstream lines( csv.str() );
+    std::string header, line;
+    std::getline( lines, header );
+    std::getline( lines, line );
+    assert( header.find( ",converged,cpu,threads,ops_per_second,efficiency,cycles_per_op," )
+            != std::string::npos );
+    assert( header.find( ",allocations_per_op,frees_per_op,bytes_per_op,samples_ns" )
+            != std::string::npos );
+    assert( std::count( header.cbegin(), header.cend(), ',' )
+            == std::count( line.cbegin(), line.cend(), ',' ) );
+    // no cpu, no counters
+    assert( line.find( ",true,,4,123456789.125,0.33333333333333331,,,,,,,,,,2,2,64,1 10 9" )
+            != std::string::npos );
+    assert( line.find( "sort,0.30000000000000004," ) == 0 );
+}
+
+void test_render_in_two_translation_units()
+{
+    auto record = sorted( 5 );
+    record.batch = 4;
+    std::ostringstream oss;
+    renderRecordDetails( oss, 2, TimeUnitOptions::NanoSecond, record );
+    assert( oss.str().find( " batch: 4" ) == 0 );
+    assert( renderedInSecondUnit( record ) == oss.str() );
+}
+
+void test_builder_output_format()
+{
+    std::ostringstream oss;
+    {
+        BasicBuilder< int >( Scaling::makeDiscrete( "n", 1, 2 ) )
+            .withOutputStream( oss )
+            .withOutputFormat( OutputFormat::Csv )
+            .withMultiplier( 4 )
+            .withRawSamples()
+            .measure( "noop", []( int ) {} );
+    }
+    std::istringstream lines( oss.str() );
+    std::string line;
+    size_t n{ 0 };
+    while ( std::getline( lines, line ) )
+    {
+        // 4 raw samples in the last column
+        assert( n == 0 || std::count( line.cbegin(), line.cend(), ' ' ) == 3 );
+        ++n;
+    }
+    assert( n == 3 );
+}
+
+int main()
+{
+    test_flatten_records_with_coordinates();
+    test_json();
+    test_csv();
+    test_json_coordinates_are_numbers();
+    test_optional_columns_and_precision();
+    test_render_in_two_translation_units();
+    test_builder_output_format();
+    return 0;
+}
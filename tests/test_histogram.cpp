@@ -0,0 +1,135 @@
+//
+// Created by weining on 18/10/26.
+//
+
+#include <cassert>
+#include <cmath>
+#include <sstream>
+#include <string>
+
+#include "autotimer.hh"
+
+using namespace AutoTimer;
+
+void test_percentiles_within_precision()
+{
+    Hdr::Histogram h( 3 );
+    for ( long v = 1; v <= 1000000; ++v )
+    {
+        h.record( Duration( v ) );
+    }
+    assert( h.count() == 1000000 );
+    assert( h.min().count() == 1 && h.max().count() == 1000000 );
+    for ( auto p : { 50.0, 90.0, 99.0, 99.9 } )
+    {
+        auto expected = p * 10000;
+        auto value = static_cast< double >( h.valueAtPercentile( p ).count() );
+        auto error = std::abs( value - expected );
+        assert( error <= expected * 1e-3 );
+    }
+    assert( h.valueAtPercentile( 100 ).count() == 1000000 );
+    assert( std::abs( static_cast< double >( h.mean().count() ) - 500000 ) < 500 );
+    // a million values in a few thousand buckets
+    assert( h.buckets().size() < 12000 );
+
+    // small values are exact
+    Hdr::Histogram small( 2 );
+    small.record( Duration( 3 ) );
+    small.record( Duration( 7 ), 3 );
+    assert( small.valueAtPercentile( 25 ).count() == 3 );
+    assert( small.valueAtPercentile( 50 ).count() == 7 );
+}
+
+void test_merge()
+{
+    Hdr::Histogram a( 2 ), b( 2 ), c( 3 );
+    for ( long v = 0; v < 1000; ++v )
+    {
+        a.record( Duration( v ) );
+        b.record( Duration( v + 1000 ) );
+        c.record( Duration( v + 1000 ) );
+    }
+    auto ab = a;
+    ab.merge( b );
+    assert( ab.count() == 2000 && ab.min().count() == 0 && ab.max().count() == 1999 );
+    auto median = ab.valueAtPercentile( 50 ).count();
+    assert( median >= 990 && median <= 1010 );
+
+    // a different precision is re-recorded bucket by bucket
+    auto ac = a;
+    ac.merge( c );
+    assert( ac.count() == 2000 );
+    assert( std::abs( ac.valueAtPercentile( 75 ).count() - 1500 ) < 20 );
+
+    // clamped to the highest trackable value
+    Hdr::Histogram bounded( 2, Duration( 1000 ) );
+    bounded.record( Duration( 5000 ) );
+    assert( bounded.max().count() == 1000 );
+}
+
+void test_attached_to_records()
+{
+    std::ostringstream oss;
+    AutoTimer::BasicBuilder< int >( Scaling::makeDiscrete( "n", 1, 2 ) )
+        .withMultiplier( 200 )
+        .withHistogram( 3 )
+        .withOutputFormat( OutputFormat::Json )
+        .withOutputStream( oss )
+        .measure( "sum", []( int n ) {
+            int x{ 0 };
+            for ( int i = 0; i < n * 10; ++i )
+            {
+                AutoTimer::doNotOptimize( x += i );
+            }
+        } );
+    auto s = oss.str();
+    assert( s.find( "\"histogram\": {\"significant_digits\": 3, \"count\": 200, "
+                    "\"buckets_ns\": [[" )
+            != std::string::npos );
+
+    auto m = AutoTimer::Impl::BasicMeasurable< std::chrono::steady_clock >( [] {} )
+                 .withMultiplier( 100 )
+                 .withHistogram();
+    auto r = m.measureRecord();
+    assert( r.histogram.count() == 100 && r.histogram.significantDigits() == 2 );
+    assert( r.histogram.valueAtPercentile( 100 ) >= std::get< 4 >( r.summary ) );
+
+    // the store keeps only the non-empty buckets and gives the histogram back
+    Report<> report{};
+    report.timeRecords = { r, r };
+    auto store = report.results();
+    size_t nonEmpty{ 0 };
+    r.histogram.forEachCount( [ &nonEmpty ]( size_t, std::uint64_t ) { ++nonEmpty; } );
+    assert( store.histogramCounts.size() == 2 * nonEmpty );
+    assert( store.histogramBuckets.size() == 2 * nonEmpty );
+    auto restored = store.histogramOf( 1 );
+    assert( restored.buckets() == r.histogram.buckets() );
+    // the bucket bounds enclose the exact extremes
+    assert( restored.min() <= r.histogram.min() && restored.max() >= r.histogram.max() );
+    auto merged = store.histogramOf( 0 ).merge( store.histogramOf( 1 ) );
+    assert( merged.count() == 200 );
+
+    // a wide precision costs a row its distinct values only
+    Hdr::Histogram fine( 5 );
+    fine.record( std::chrono::seconds( 1 ) );
+    fine.record( Duration( 10 ) );
+    auto wide = r;
+    wide.histogram = fine;
+    Report<> sparse{};
+    sparse.timeRecords = { wide };
+    auto sparseStore = sparse.results();
+    assert( fine.buckets().size() > 100000 );
+    assert( sparseStore.histogramCounts.size() == 2 );
+    assert( sparseStore.histogramOf( 0 ).valueAtPercentile( 100 ) >= std::chrono::seconds( 1 ) );
+    std::ostringstream text;
+    report.formatted( text, TimeUnitOptions::NanoSecond );
+    assert( text.str().find( "histogram: p99.99: " ) != std::string::npos );
+}
+
+int main()
+{
+    test_percentiles_within_precision();
+    test_merge();
+    test_attached_to_records();
+    return 0;
+}
@@ -5,7 +5,9 @@
 #include <cassert>
 #include <chrono>
 #include <sstream>
+#include <string>
 #include <type_traits>
+#include <vector>
 
 #include "impl/measurable.hh"
 #include "impl/time_record.hh"
@@ -30,5 +32,92 @@ int main()
     assert( !oss.str().empty() );
     assert( state == 1 );
 
+    // the harness overhead is reported with every record, an empty task sits on the noise floor
+    auto record = Measurable( []() {} ).withMultiplier( 100 ).measureRecord();
+    assert( record.overhead.count() > 0 );
+    assert( record.nearNoiseFloor );
+    auto subtracted =
+        Measurable( []() {} ).withMultiplier( 100 ).withOverheadSubtraction().measureRecord();
+    assert( std::get< 3 >( subtracted.summary ) <= std::get< 3 >( record.summary ) );
+
+    // copies share the concrete callable instead of cloning it
+    size_t calls{ 0 };
+    Measurable counting( [ &calls ]() { ++calls; } );
+    auto copy = counting;
+    assert( copy.subject == counting.subject );
+    auto summary10 = copy.withMultiplier( 10 ).measure();
+    assert( std::get< 1 >( summary10 ) == 10 );
+    assert( calls == 10 );
+
+    // batched samples time k invocations each and report the time per invocation
+    calls = 0;
+    auto batched = Measurable( [ &calls ]() { ++calls; } ).withMultiplier( 10 ).withBatch( 8 );
+    auto batchedRecord = batched.measureRecord();
+    assert( calls == 80 );
+    assert( batchedRecord.batch == 8 );
+    assert( batchedRecord.batchMin <= batchedRecord.batchMax );
+    assert( std::get< 4 >( batchedRecord.summary ) <= batchedRecord.batchMax );
+
+    calls = 0;
+    auto autoBatched = Measurable( [ &calls ]() { ++calls; } )
+                           .withAutoBatch( std::chrono::microseconds( 10 ) )
+                           .measureRecord();
+    // whatever the optimizer makes of the task, the batch grows, stays capped and every
+    // invocation of the one measured sample is made
+    assert( autoBatched.batch > 1 && autoBatched.batch <= Measurable::maxBatch );
+    assert( calls > autoBatched.batch );
+    assert( autoBatched.batch == Measurable::maxBatch
+            || autoBatched.batchMax >= std::chrono::microseconds( 1 ) );
+
+    // adaptive sampling keeps going until the interval converges or the budget is spent
+    auto adaptive = Measurable( []() {} )
+                        .withTargetPrecision( 0.0 )
+                        .withTimeBudget( std::chrono::milliseconds( 20 ) )
+                        .measureRecord();
+    assert( !adaptive.converged );
+    assert( std::get< 1 >( adaptive.summary ) > 10 );
+    auto converged = Measurable( []() {} ).withTargetPrecision( 1e6 ).measureRecord();
+    assert( converged.converged );
+    assert( std::get< 1 >( converged.summary ) >= Measurable::minAdaptiveRuns );
+    assert( std::get< 1 >( converged.summary ) < 2 * Measurable::minAdaptiveRuns );
+
+    // warmup samples run but are not part of the summary
+    calls = 0;
+    auto warm = Measurable( [ &calls ]() { ++calls; } ).withWarmup( 5 ).withMultiplier( 10 );
+    auto warmRecord = warm.measureRecord();
+    assert( calls == 15 );
+    assert( warmRecord.warmupRuns == 5 );
+    assert( std::get< 1 >( warmRecord.summary ) == 10 );
+    auto stable = Measurable( []() {} ).withWarmupUntilStable( 100 ).measureRecord();
+    assert( stable.warmupRuns >= 20 && stable.warmupRuns <= 100 );
+
+    // setup and teardown run around every sample, setup knows the batch size
+    std::vector< size_t > log;
+    auto hooked = Measurable( [ &log ]() { log.push_back( 0 ); } )
+                      .withMultiplier( 3 )
+                      .withBatch( 2 )
+                      .withBatchSetup( [ &log ]( size_t k ) { log.push_back( 10 + k ); } )
+                      .withTeardown( [ &log ]() { log.push_back( 1 ); } );
+    auto hookedRecord = hooked.measureRecord();
+    assert( std::get< 1 >( hookedRecord.summary ) == 3 );
+    assert( ( log == std::vector< size_t >{ 12, 0, 0, 1, 12, 0, 0, 1, 12, 0, 0, 1 } ) );
+
+    // the bootstrap confidence intervals are opt-in
+    auto plain = Measurable( []() {} ).withMultiplier( 20 ).measureRecord();
+    assert( plain.statistics.meanInterval.upper.count() == 0 );
+    auto bootstrapped = Measurable( []() {} ).withMultiplier( 20 ).withBootstrap().measureRecord();
+    auto interval = bootstrapped.statistics.meanInterval;
+    assert( interval.upper.count() > 0 && interval.lower <= interval.upper );
+
+    // a task may return a value, which is sunk instead of discarded
+    int sunk{ 0 };
+    auto returning = Measurable( [ &sunk ]() { return ++sunk; } ).withMultiplier( 5 ).measure();
+    assert( sunk == 5 );
+    assert( std::get< 1 >( returning ) == 5 );
+    int x{ 42 };
+    AutoTimer::doNotOptimize( x );
+    AutoTimer::doNotOptimize( std::string( "escaped" ) );
+    AutoTimer::clobberMemory();
+
     return 0;
 }
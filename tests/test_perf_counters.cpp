@@ -0,0 +1,90 @@
+//
+// Created by weining on 18/10/26.
+//
+
+#include <cassert>
+#include <sstream>
+#include <vector>
+
+#include "autotimer.hh"
+
+using AutoTimer::TimeRecord::Counters;
+
+void test_counter_group_degrades_gracefully()
+{
+    // whatever the kernel allows (possibly nothing), reading must not fail
+    AutoTimer::Perf::CounterGroup group;
+    std::vector< int > xs( 1 << 16, 1 );
+    group.start();
+    long sum{ 0 };
+    for ( auto x : xs )
+    {
+        sum += x;
+    }
+    AutoTimer::doNotOptimize( sum );
+    group.stop();
+    auto c = group.read( static_cast< double >( xs.size() ) );
+    assert( group.empty() == !c.any() );
+    for ( size_t e = 0; e < Counters::EventCount; ++e )
+    {
+        assert( c.available[ e ] || c.perOp[ e ] == 0 );
+        assert( c.perOp[ e ] >= 0 );
+    }
+    if ( c.available[ Counters::TaskClock ] )
+    {
+        assert( c.perOp[ Counters::TaskClock ] > 0 );
+    }
+}
+
+void test_ipc_needs_both_counters()
+{
+    Counters c{};
+    c.perOp[ Counters::Cycles ] = 100;
+    c.perOp[ Counters::Instructions ] = 250;
+    c.available[ Counters::Cycles ] = true;
+    assert( c.ipc() == 0 );
+    c.available[ Counters::Instructions ] = true;
+    assert( c.ipc() == 2.5 );
+}
+
+void test_render_counters_per_op()
+{
+    AutoTimer::TimeRecord::RecordMultiDim<> r{};
+    r.counters.perOp[ Counters::Cycles ] = 100;
+    r.counters.perOp[ Counters::Instructions ] = 250;
+    r.counters.perOp[ Counters::PageFaults ] = 0.5;
+    r.counters.available[ Counters::Cycles ] = true;
+    r.counters.available[ Counters::Instructions ] = true;
+    r.counters.available[ Counters::PageFaults ] = true;
+    std::ostringstream oss;
+    AutoTimer::render( oss, 0, AutoTimer::TimeUnitOptions::NanoSecond, r );
+    assert( oss.str().find( "per op: IPC: 2.50, cycles: 100.00, instructions: 250.00, "
+                            "page-faults: 0.50\n" )
+            != std::string::npos );
+}
+
+void test_measure_with_perf_counters()
+{
+    std::ostringstream oss;
+    {
+        AutoTimer::Builder()
+            .withOutputStream( oss )
+            .withMultiplier( 10 )
+            .withPerfCounters()
+            .measure( []() {
+                std::vector< int > xs( 1024, 1 );
+                AutoTimer::doNotOptimize( xs.data() );
+            } );
+    }
+    AutoTimer::Perf::CounterGroup probe;
+    assert( probe.empty() || oss.str().find( "per op:" ) != std::string::npos );
+}
+
+int main()
+{
+    test_counter_group_degrades_gracefully();
+    test_ipc_needs_both_counters();
+    test_render_counters_per_op();
+    test_measure_with_perf_counters();
+    return 0;
+}
@@ -0,0 +1,95 @@
+//
+// Created by weining on 18/10/26.
+//
+
+#include <cassert>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "autotimer.hh"
+#include "records.hh"
+
+using namespace AutoTimer;
+using namespace TestRecords;
+
+Report< std::string, int, int > threeDimensionalReport()
+{
+    auto inner = along< int >( "size", { { 10, sorted( 10, 1 ) }, { 20, sorted( 20, 2 ) } } );
+    auto middle = along< int, int >( "threads", { { 1, inner }, { 2, inner } } );
+    auto outer =
+        along< std::string, int, int >( "mode", { { "cold", middle }, { "warm", middle } } );
+    Report< std::string, int, int > report{};
+    report.label = "store";
+    report.timeRecords = { outer, outer };
+    return report;
+}
+
+void test_columns_from_record_trees()
+{
+    auto store = threeDimensionalReport().results();
+    assert( store.size() == 16 );
+    assert( store.dimensionLabel( 0 ) == "mode" && store.dimensionLabel( 2 ) == "size" );
+    // "sort", the three dimension labels
+    assert( store.strings.size() == 4 );
+    assert( std::get< 0 >( store.coordinates )[ 4 ] == "warm" );
+    assert( std::get< 2 >( store.coordinates )[ 5 ] == 20 );
+    assert( store.record[ 7 ] == 0 && store.record[ 8 ] == 1 );
+    std::vector< int > divergence( store.divergence.cbegin(), store.divergence.cbegin() + 9 );
+    assert( ( divergence == std::vector< int >{ 0, 2, 1, 2, 0, 2, 1, 2, 0 } ) );
+
+    // all samples in one array
+    assert( store.samples.size() == 24 );
+    assert( store.samplesOf( 0 ).size() == 1 && store.samplesOf( 1 ).size() == 2 );
+    assert( store.samplesOf( 1 ).begin()->count() == 20 );
+
+    auto r = store.leaf( 3 );
+    assert( r.label() == "sort" && std::get< 2 >( r.summary ).count() == 20 );
+    assert( r.samples.size() == 2 );
+    assert( std::get< 1 >( store.pointOf( 3 ) ) == 2 );
+    auto coordinates = store.coordinatesOf( 3 );
+    assert( coordinates[ 0 ].value == "cold" && coordinates[ 1 ].numeric );
+}
+
+void test_text_matches_the_record_tree()
+{
+    auto report = threeDimensionalReport();
+    std::ostringstream tree;
+    tree << report.label << '\n';
+    for ( const auto& timeRecord : report.timeRecords )
+    {
+        render( tree, 4, TimeUnitOptions::NanoSecond, timeRecord );
+    }
+    std::ostringstream columns;
+    report.results().formatted( columns, TimeUnitOptions::NanoSecond );
+    assert( tree.str() == columns.str() );
+}
+
+void test_builder_writes_rows()
+{
+    std::ostringstream oss;
+    AutoTimer::BasicBuilder< int, int >( Scaling::makeLinear( "x", 0, 4 ),
+                                         Scaling::makeLinear( "y", 0, 4 ) )
+        .withSampling( Scaling::Sampling::random( 5 ) )
+        .withOutputFormat( OutputFormat::Csv )
+        .withOutputStream( oss )
+        .measure( "a", []( int, int ) {} )
+        .measure( "b", []( int, int ) {} );
+    std::istringstream lines( oss.str() );
+    std::string line;
+    size_t rows{ 0 };
+    while ( std::getline( lines, line ) )
+    {
+        ++rows;
+    }
+    // the header plus the five sampled points of both measures
+    assert( rows == 11 );
+}
+
+int main()
+{
+    test_columns_from_record_trees();
+    test_text_matches_the_record_tree();
+    test_builder_writes_rows();
+    return 0;
+}
@@ -7,11 +7,16 @@
 #include <impl/export.hh>
 #include <impl/measurable.hh>
 
+#include <algorithm>
 #include <cassert>
+#include <climits>
+#include <cstdint>
+#include <cmath>
 #include <functional>
 #include <iostream>
 #include <sstream>
 #include <type_traits>
+#include <vector>
 
 template < typename T >
 class TypeTester;
@@ -41,9 +46,171 @@ void test_scale_function()
     AutoTimer::render( std::cout, 0, AutoTimer::TimeUnitOptions::MicroSecond, r ) << '\n';
 }
 
+void test_parallel_sweep_matches_sequential_layout()
+{
+    using namespace AutoTimer::Scaling;
+    auto me = AutoTimer::Impl::Measurable< int, int >( []( int a, int b ) { fib( a + b ); } );
+    auto params = std::make_tuple( makeLinear( "a", 1, 4 ), makeDiscrete( "b", 2, 4 ) );
+    auto sequential = scaleTu( me, params );
+    auto parallel = scaleParallelTu( me, params );
+
+    assert( parallel.label == "a" );
+    assert( parallel.fields.size() == sequential.fields.size() );
+    for ( size_t i = 0; i < parallel.fields.size(); ++i )
+    {
+        const auto& [ a, inner ] = parallel.fields[ i ];
+        assert( a == std::get< 0 >( sequential.fields[ i ] ) );
+        assert( inner.label == "b" );
+        assert( inner.fields.size() == 2 );
+        for ( const auto& [ b, leaf ] : inner.fields )
+        {
+            assert( std::get< 1 >( leaf.summary ) == 1 );
+            assert( leaf.cpu < 0
+                    || !AutoTimer::Affinity::isolatedCores( { leaf.cpu } ).empty() );
+        }
+    }
+    AutoTimer::render( std::cout, 0, AutoTimer::TimeUnitOptions::MicroSecond, parallel ) << '\n';
+}
+
+void test_isolated_cores_skip_smt_siblings()
+{
+    assert( ( AutoTimer::Affinity::parseCpuList( "0-2,5" ) == std::vector< int >{ 0, 1, 2, 5 } ) );
+    auto cores = AutoTimer::Affinity::isolatedCores();
+    for ( auto cpu : cores )
+    {
+        for ( auto sibling : AutoTimer::Affinity::smtSiblings( cpu ) )
+        {
+            assert( sibling == cpu
+                    || std::find( cores.cbegin(), cores.cend(), sibling ) == cores.cend() );
+        }
+    }
+}
+
+void test_geometric_and_strided_generators()
+{
+    using namespace AutoTimer::Scaling;
+    auto [ label, geometric ] = makeGeometric( "size", 1024, 1 << 24 );
+    assert( label == "size" );
+    auto sizes = valuesOf( *geometric );
+    assert( sizes.size() == 15 && sizes.front() == 1024 && sizes.back() == 1 << 24 );
+
+    auto tenfold = valuesOf( *std::get< 1 >( makeGeometric( 1, 1000, 10 ) ) );
+    assert( ( tenfold == std::vector< int >{ 1, 10, 100, 1000 } ) );
+
+    // a factor too small to change an integer still makes progress
+    auto slow = valuesOf( *std::get< 1 >( makeGeometric( 1, 4, 1.1 ) ) );
+    assert( ( slow == std::vector< int >{ 1, 2, 3, 4 } ) );
+
+    // an end close to the largest value stops the series without overflowing
+    auto large = valuesOf( *std::get< 1 >( makeGeometric( 1 << 29, INT_MAX - 1, 1.5 ) ) );
+    assert( ( large == std::vector< int >{ 1 << 29, 805306368, 1207959552, 1811939328 } ) );
+    auto huge = valuesOf( *std::get< 1 >( makeGeometric( 1L, LONG_MAX - 1 ) ) );
+    assert( huge.size() == 64 && huge[ 62 ] == 1L << 62 && huge.back() == LONG_MAX - 1 );
+    auto real = valuesOf( *std::get< 1 >( makeGeometric( 1.0, 8.0 ) ) );
+    assert( ( real == std::vector< double >{ 1.0, 2.0, 4.0, 8.0 } ) );
+
+    auto strided = valuesOf( *std::get< 1 >( makeStrided( "stride", 0, 100, 25 ) ) );
+    assert( ( strided == std::vector< int >{ 0, 25, 50, 75 } ) );
+    auto down = valuesOf( *std::get< 1 >( makeStrided( 3.0, 0.0, -1.5 ) ) );
+    assert( ( down == std::vector< double >{ 3.0, 1.5 } ) );
+    // strides close to the limits stop at the end without overflowing
+    auto wide = valuesOf( *std::get< 1 >( makeStrided( "n", 0, INT_MAX, 1 << 30 ) ) );
+    assert( ( wide == std::vector< int >{ 0, 1 << 30 } ) );
+    auto full = valuesOf( *std::get< 1 >( makeStrided( INT_MIN, INT_MAX, 1 << 30 ) ) );
+    assert( ( full == std::vector< int >{ INT_MIN, -( 1 << 30 ), 0, 1 << 30 } ) );
+    auto downward = valuesOf( *std::get< 1 >( makeStrided( INT_MAX, INT_MIN, INT_MIN ) ) );
+    assert( ( downward == std::vector< int >{ INT_MAX, -1 } ) );
+
+    // any value type with begin/end/next works
+    struct Squares
+    {
+        int begin() const
+        {
+            return 1;
+        }
+        bool end( int n ) const
+        {
+            return n > 100;
+        }
+        int next( int n ) const
+        {
+            auto root = static_cast< int >( std::sqrt( n ) );
+            return ( root + 1 ) * ( root + 1 );
+        }
+    };
+    auto squares = valuesOf( *std::get< 1 >( makeParameter( "squares", Squares{} ) ) );
+    assert( squares.size() == 10 && squares.back() == 100 );
+
+    auto discrete = valuesOf( *std::get< 1 >( makeDiscrete( 3, 1, 2 ) ) );
+    assert( ( discrete == std::vector< int >{ 3, 1, 2 } ) );
+}
+
+void test_select_points()
+{
+    using namespace AutoTimer::Scaling;
+    GridIndex< 2 > sizes{ 10, 20 };
+    assert( selectPoints( sizes, Sampling{} ).size() == 200 );
+    // asking for more than the grid holds yields the grid
+    assert( selectPoints( sizes, Sampling::random( 500 ) ).size() == 200 );
+
+    auto random = selectPoints( sizes, Sampling::random( 30 ) );
+    assert( random.size() == 30 );
+    assert( std::is_sorted( random.cbegin(), random.cend() ) );
+    assert( std::adjacent_find( random.cbegin(), random.cend() ) == random.cend() );
+    assert( random == selectPoints( sizes, Sampling::random( 30 ) ) );
+
+    // every stratum of every dimension is hit exactly once
+    auto lhs = selectPoints( sizes, Sampling::latinHypercube( 10 ) );
+    assert( lhs.size() == 10 );
+    std::vector< int > rows( 10 ), columns( 10 );
+    for ( const auto& index : lhs )
+    {
+        ++rows[ index[ 0 ] ];
+        ++columns[ index[ 1 ] / 2 ];
+    }
+    assert( std::all_of( rows.cbegin(), rows.cend(), []( int n ) { return n == 1; } ) );
+    assert( std::all_of( columns.cbegin(), columns.cend(), []( int n ) { return n == 1; } ) );
+
+    // on a grid coarser than the strata the points coincide, and are made up by distinct ones
+    GridIndex< 2 > coarse{ 3, 4 };
+    for ( std::uint64_t seed = 0; seed < 20; ++seed )
+    {
+        auto covering = selectPoints( coarse, Sampling::latinHypercube( 10, seed ) );
+        assert( covering.size() == 10 );
+        assert( std::is_sorted( covering.cbegin(), covering.cend() ) );
+        assert( std::adjacent_find( covering.cbegin(), covering.cend() ) == covering.cend() );
+        assert( std::all_of( covering.cbegin(), covering.cend(), [ &coarse ]( const auto& index ) {
+            return index[ 0 ] < coarse[ 0 ] && index[ 1 ] < coarse[ 1 ];
+        } ) );
+    }
+    auto grid = selectPoints( coarse, Sampling{} );
+    assert( grid.size() == 12 && grid[ 5 ] == ( GridIndex< 2 >{ 1, 1 } ) );
+}
+
+void test_sampled_sweep()
+{
+    using namespace AutoTimer::Scaling;
+    auto me = AutoTimer::Impl::Measurable< int, int >( []( int, int ) {} );
+    auto params = std::make_tuple( makeGeometric( "a", 1, 1 << 20 ), makeStrided( "b", 0, 90, 3 ) );
+    auto r = scaleSampledTu( me, params, Sampling::latinHypercube( 12 ) );
+    assert( r.label == "a" );
+    size_t leaves{ 0 };
+    for ( const auto& [ a, inner ] : r.fields )
+    {
+        assert( inner.label == "b" && !inner.fields.empty() );
+        leaves += inner.fields.size();
+    }
+    assert( leaves == 12 );
+}
+
 int main()
 {
     test_produce_multi_dimensional_time_record();
     test_scale_function();
+    test_parallel_sweep_matches_sequential_layout();
+    test_isolated_cores_skip_smt_siblings();
+    test_geometric_and_strided_generators();
+    test_select_points();
+    test_sampled_sweep();
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,93 @@
+//
+// Created by weining on 18/10/26.
+//
+
+#include "impl/spans.hh"
+#include "impl/timer.hh"
+
+#include <algorithm>
+#include <cassert>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+void test_ring_buffer_rejects_when_full()
+{
+    AutoTimer::Spans::RingBuffer< int, 4 > ring;
+    for ( int i = 0; i < 4; ++i )
+    {
+        assert( ring.tryPush( i ) );
+    }
+    assert( !ring.tryPush( 4 ) );
+
+    int sum{ 0 };
+    assert( ring.drain( [ &sum ]( int x ) { sum += x; } ) == 4 );
+    assert( sum == 6 );
+    assert( ring.tryPush( 5 ) );
+}
+
+void test_span_timers_aggregate_across_threads()
+{
+    auto& collector = AutoTimer::Spans::SpanCollector::instance();
+    collector.withReportOnExit( nullptr );
+
+    std::vector< std::thread > workers;
+    for ( int t = 0; t < 4; ++t )
+    {
+        workers.emplace_back( []() {
+            for ( int i = 0; i < 100; ++i )
+            {
+                AutoTimer::SpanTimer atm( "worker()" );
+            }
+        } );
+    }
+    for ( auto& worker : workers )
+    {
+        worker.join();
+    }
+
+    auto summaries = collector.summaries();
+    assert( summaries.size() == 1 );
+    assert( std::get< 0 >( summaries[ 0 ] ) == "worker()" );
+    assert( std::get< 1 >( summaries[ 0 ] ) == 400 );
+
+    std::ostringstream oss;
+    collector.formatted( oss, AutoTimer::TimeUnitOptions::MicroSecond );
+    assert( oss.str().find( "worker(): " ) != std::string::npos );
+}
+
+void test_buffers_released_after_thread_exit()
+{
+    auto& collector = AutoTimer::Spans::SpanCollector::instance();
+    for ( int t = 0; t < 8; ++t )
+    {
+        std::thread( []() { AutoTimer::SpanTimer atm( "request()" ); } ).join();
+    }
+    collector.flush();
+    assert( collector.liveBuffers() == 0 );
+    auto summaries = collector.summaries();
+    assert( std::get< 0 >( summaries[ 1 ] ) == "request()" );
+    assert( std::get< 1 >( summaries[ 1 ] ) == 8 );
+}
+
+void test_label_cache_checks_reused_addresses()
+{
+    auto& collector = AutoTimer::Spans::SpanCollector::instance();
+    char name[] = "first";
+    auto first = collector.localLabel( name );
+    std::copy_n( "other", 6, name );
+    auto other = collector.localLabel( name );
+    assert( first != other );
+    assert( collector.labels().name( first ) == "first" );
+    assert( collector.labels().name( other ) == "other" );
+    assert( collector.localLabel( "other" ) == other );
+}
+
+int main()
+{
+    test_ring_buffer_rejects_when_full();
+    test_span_timers_aggregate_across_threads();
+    test_buffers_released_after_thread_exit();
+    test_label_cache_checks_reused_addresses();
+    return 0;
+}
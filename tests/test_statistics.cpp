@@ -0,0 +1,99 @@
+//
+// Created by weining on 18/10/26.
+//
+
+#include "impl/statistics.hh"
+#include "impl/time_record.hh"
+
+#include <algorithm>
+#include <cassert>
+#include <vector>
+
+void test_percentile_interpolates_between_ranks()
+{
+    std::vector< double > xs{ 1, 2, 3, 4, 5 };
+    assert( AutoTimer::Stats::percentile( xs, 0.0 ) == 1.0 );
+    assert( AutoTimer::Stats::percentile( xs, 0.5 ) == 3.0 );
+    assert( AutoTimer::Stats::percentile( xs, 0.875 ) == 4.5 );
+    assert( AutoTimer::Stats::percentile( xs, 1.0 ) == 5.0 );
+}
+
+void test_describe_samples()
+{
+    using AutoTimer::TimeRecord::Duration;
+    std::vector< Duration > ds;
+    for ( long i = 1; i <= 100; ++i )
+    {
+        ds.emplace_back( i );
+    }
+    auto s = AutoTimer::Stats::describe( ds );
+    assert( s.median == Duration( 51 ) );  // 50.5 rounds away from zero
+    assert( s.p90 == Duration( 90 ) );
+    assert( s.p99 == Duration( 99 ) );
+    assert( s.mad == Duration( 25 ) );
+    assert( s.stddev == Duration( 29 ) );
+    assert( s.meanInterval.lower < Duration( 51 ) && Duration( 50 ) < s.meanInterval.upper );
+    assert( s.medianInterval.lower <= s.median && s.median <= s.medianInterval.upper );
+
+    auto noBootstrap = AutoTimer::Stats::describe( ds, 0 );
+    assert( noBootstrap.meanInterval.upper == Duration{} );
+}
+
+void test_outliers_beyond_tukey_fences()
+{
+    using AutoTimer::TimeRecord::Duration;
+    std::vector< Duration > ds;
+    for ( long i = 0; i < 20; ++i )
+    {
+        ds.emplace_back( 100 + i % 5 );
+    }
+    ds.emplace_back( 109 );   // mild: between q3 + 1.5 iqr and q3 + 3 iqr
+    ds.emplace_back( 1000 );  // severe
+    std::sort( ds.begin(), ds.end() );
+
+    auto o = AutoTimer::Stats::classifyOutliers( ds );
+    assert( o.highMild == 1 && o.highSevere == 1 );
+    assert( o.lowMild == 0 && o.lowSevere == 0 );
+
+    auto severe = ds;
+    AutoTimer::Stats::rejectOutliers( severe, AutoTimer::OutlierRejection::Severe );
+    assert( severe.size() == ds.size() - 1 );
+    AutoTimer::Stats::rejectOutliers( ds, AutoTimer::OutlierRejection::All );
+    assert( ds.back() == Duration( 104 ) );
+}
+
+void test_mann_whitney_one_sided()
+{
+    using AutoTimer::Stats::mannWhitney;
+    auto separated = mannWhitney( { 1, 2, 3 }, { 4, 5, 6 } );
+    assert( separated.probabilitySmaller == 1.0 );
+    assert( separated.pValue > 0.03 && separated.pValue < 0.05 );
+
+    auto reversed = mannWhitney( { 4, 5, 6 }, { 1, 2, 3 } );
+    assert( reversed.probabilitySmaller == 0.0 );
+    assert( reversed.pValue > 0.95 );
+
+    // ties count half
+    auto tied = mannWhitney( { 5, 5, 5, 5 }, { 5, 5, 5, 5 } );
+    assert( tied.probabilitySmaller == 0.5 );
+    assert( tied.pValue >= 0.5 );
+
+    std::vector< double > xs, ys;
+    for ( int i = 0; i < 50; ++i )
+    {
+        xs.push_back( 100 + i % 10 );
+        ys.push_back( 105 + i % 10 );
+    }
+    auto overlapping = mannWhitney( xs, ys );
+    assert( overlapping.probabilitySmaller > 0.7 && overlapping.probabilitySmaller < 1.0 );
+    assert( overlapping.pValue < 0.001 );
+}
+
+int main()
+{
+    test_percentile_interpolates_between_ranks();
+    test_describe_samples();
+    test_outliers_beyond_tukey_fences();
+    test_mann_whitney_one_sided();
+    return 0;
+}